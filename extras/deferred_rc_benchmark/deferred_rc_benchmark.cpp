@@ -0,0 +1,186 @@
+/// \file deferred_rc_benchmark.cpp
+/// \brief Compares eager reference counting with shared_ptr against deferred reference counting with local_ptr.
+/// \details Build and run on the host:
+///
+///     c++ -std=c++11 -O2 -Isrc -o deferred_rc_benchmark extras/deferred_rc_benchmark/deferred_rc_benchmark.cpp
+///     ./deferred_rc_benchmark [nodes] [passes]
+///
+/// Runs three workloads with both schemes. "traverse" walks a linked list through a local pointer, "search" passes
+/// each node to a function that keeps a local copy, and "churn" replaces list nodes, which with deferred counting
+/// includes the cost of reconciling the zero count table after each pass.
+#include <smart_ptr.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+// NODES
+/// \brief A list node of the eager scheme.
+struct eager_node
+{
+    /// \brief The value of the node.
+    long value;
+    /// \brief The next node.
+    shared_ptr<eager_node> next;
+};
+/// \brief A list node of the deferred scheme.
+struct deferred_node
+{
+    /// \brief The value of the node.
+    long value;
+    /// \brief The next node.
+    deferred_ptr<deferred_node> next;
+};
+
+/// \brief Prevents the compiler from removing the benchmarked work.
+volatile long sink;
+
+/// \brief Measures a workload.
+/// \tparam eager_type The type of the workload using shared_ptr.
+/// \tparam deferred_type The type of the workload using deferred_ptr and local_ptr.
+/// \param name The name of the workload.
+/// \param steps The number of steps the workload performs.
+/// \param eager The workload using shared_ptr.
+/// \param deferred The workload using deferred_ptr and local_ptr.
+template <class eager_type, class deferred_type>
+void measure(const char* name, double steps, eager_type eager, deferred_type deferred)
+{
+    auto start = std::chrono::steady_clock::now();
+    eager();
+    auto middle = std::chrono::steady_clock::now();
+    deferred();
+    auto end = std::chrono::steady_clock::now();
+
+    double eager_ns = std::chrono::duration<double, std::nano>(middle - start).count() / steps;
+    double deferred_ns = std::chrono::duration<double, std::nano>(end - middle).count() / steps;
+    std::printf("%-10s %10.2f %10.2f %9.2fx\n", name, eager_ns, deferred_ns, eager_ns / deferred_ns);
+}
+
+/// \brief Keeps a local copy of a node and reads it, as a callee taking a shared_ptr by value does.
+/// \param node The node.
+/// \return The value of the node.
+long eager_visit(shared_ptr<eager_node> node)
+{
+    return node->value;
+}
+/// \brief Keeps a local copy of a node and reads it.
+/// \param node The node.
+/// \return The value of the node.
+long deferred_visit(const local_ptr<deferred_node>& node)
+{
+    local_ptr<deferred_node> copy = node;
+    return copy->value;
+}
+
+int main(int argc, char** argv)
+{
+    long nodes = argc > 1 ? std::atol(argv[1]) : 1000;
+    long passes = argc > 2 ? std::atol(argv[2]) : 10000;
+
+    // Build the lists.
+    shared_ptr<eager_node> eager_head;
+    deferred_ptr<deferred_node> deferred_head;
+    for(long i = 0; i < nodes; ++i)
+    {
+        shared_ptr<eager_node> eager = make_shared<eager_node>();
+        eager->value = i;
+        eager->next = eager_head;
+        eager_head = eager;
+
+        deferred_ptr<deferred_node> deferred = make_deferred<deferred_node>();
+        deferred->value = i;
+        deferred->next = deferred_head;
+        deferred_head = deferred;
+    }
+
+    std::printf("%-10s %10s %10s %10s\n", "workload", "eager ns", "deferred", "speedup");
+    double steps = static_cast<double>(nodes) * static_cast<double>(passes);
+
+    measure("traverse", steps, [&]()
+    {
+        for(long pass = 0; pass < passes; ++pass)
+        {
+            long sum = 0;
+            for(shared_ptr<eager_node> current = eager_head; current; current = current->next)
+            {
+                sum += current->value;
+            }
+            sink = sum;
+        }
+    }, [&]()
+    {
+        for(long pass = 0; pass < passes; ++pass)
+        {
+            long sum = 0;
+            for(local_ptr<deferred_node> current = deferred_head; current; current = current->next)
+            {
+                sum += current->value;
+            }
+            sink = sum;
+        }
+    });
+
+    measure("search", steps, [&]()
+    {
+        for(long pass = 0; pass < passes; ++pass)
+        {
+            long sum = 0;
+            for(shared_ptr<eager_node> current = eager_head; current; current = current->next)
+            {
+                sum += eager_visit(current);
+            }
+            sink = sum;
+        }
+    }, [&]()
+    {
+        for(long pass = 0; pass < passes; ++pass)
+        {
+            long sum = 0;
+            for(local_ptr<deferred_node> current = deferred_head; current; current = current->next)
+            {
+                sum += deferred_visit(current);
+            }
+            sink = sum;
+        }
+    });
+
+    // Replace every node of the list on each pass. Fewer passes keep the allocation work comparable to the others.
+    long churn_passes = passes / 100 > 0 ? passes / 100 : 1;
+    measure("churn", static_cast<double>(nodes) * static_cast<double>(churn_passes), [&]()
+    {
+        for(long pass = 0; pass < churn_passes; ++pass)
+        {
+            shared_ptr<eager_node> replaced;
+            for(shared_ptr<eager_node> current = eager_head; current; current = current->next)
+            {
+                shared_ptr<eager_node> node = make_shared<eager_node>();
+                node->value = current->value;
+                node->next = replaced;
+                replaced = node;
+            }
+            eager_head = replaced;
+        }
+    }, [&]()
+    {
+        for(long pass = 0; pass < churn_passes; ++pass)
+        {
+            {
+                deferred_ptr<deferred_node> replaced;
+                for(local_ptr<deferred_node> current = deferred_head; current; current = current->next)
+                {
+                    deferred_ptr<deferred_node> node = make_deferred<deferred_node>();
+                    node->value = current->value;
+                    node->next = replaced;
+                    replaced = node;
+                }
+                deferred_head = replaced;
+            }
+            deferred_heap::reconcile();
+        }
+    });
+
+    // Free the deferred list.
+    deferred_head.reset();
+    deferred_heap::reconcile();
+    return 0;
+}
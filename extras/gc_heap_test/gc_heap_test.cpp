@@ -0,0 +1,186 @@
+/// \file gc_heap_test.cpp
+/// \brief Tests the gc_heap collector.
+/// \details Build and run on the host, preferably with the address sanitizer:
+///
+///     c++ -std=c++11 -g -fsanitize=address,undefined -Isrc -o gc_heap_test extras/gc_heap_test/gc_heap_test.cpp
+///     ./gc_heap_test
+///
+/// Prints each failed check and exits with a nonzero status if any check failed.
+#include <smart_ptr.hpp>
+
+#include <cstdio>
+
+/// \brief The number of failed checks.
+int failures = 0;
+
+/// \brief Records a failed check.
+#define CHECK(condition) do { if(!(condition)) { std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); ++failures; } } while(0)
+
+// TYPES
+/// \brief The number of live leaves and pairs.
+int live = 0;
+
+/// \brief An object without references.
+struct leaf
+{
+    /// \brief Creates a new leaf.
+    /// \param value The value of the leaf.
+    leaf(int value = 0)
+        : value(value)
+    {
+        ++live;
+    }
+    ~leaf()
+    {
+        --live;
+    }
+
+    /// \brief The value of the leaf.
+    int value;
+};
+
+/// \brief An object referencing two leaves, which it allocates in its constructor.
+struct pair
+{
+    /// \brief Creates a new pair with two new leaves.
+    /// \param heap The heap to allocate the leaves on.
+    pair(gc_heap& heap)
+    {
+        ++live;
+        first = make_gc<leaf>(heap, 1);
+        second = make_gc<leaf>(heap, 2);
+    }
+    ~pair()
+    {
+        --live;
+    }
+
+    /// \brief The first leaf.
+    gc_member<leaf> first;
+    /// \brief The second leaf.
+    gc_member<leaf> second;
+};
+/// \brief Traces the leaves of a pair.
+template <>
+struct gc_trace<pair>
+{
+    /// \brief Marks the leaves of a pair.
+    /// \param object The pair.
+    /// \param heap The heap performing the collection.
+    static void trace(pair& object, gc_heap& heap)
+    {
+        heap.mark(object.first);
+        heap.mark(object.second);
+    }
+};
+
+/// \brief A node of a linked cycle.
+struct node
+{
+    /// \brief Creates a new node.
+    node()
+    {
+        ++live;
+    }
+    ~node()
+    {
+        --live;
+    }
+
+    /// \brief The next node.
+    gc_member<node> next;
+};
+/// \brief Traces the successor of a node.
+template <>
+struct gc_trace<node>
+{
+    /// \brief Marks the successor of a node.
+    /// \param object The node.
+    /// \param heap The heap performing the collection.
+    static void trace(node& object, gc_heap& heap)
+    {
+        heap.mark(object.next);
+    }
+};
+
+// TESTS
+/// \brief Checks that unreachable cycles are freed and reachable ones are kept.
+void test_cycles()
+{
+    gc_heap heap(1024, 16);
+    {
+        // Build a reachable cycle of three nodes and an unreachable one of two.
+        gc_ptr<node> kept = make_gc<node>(heap);
+        kept->next = make_gc<node>(heap);
+        kept->next->next = make_gc<node>(heap);
+        kept->next->next->next = kept;
+        {
+            gc_ptr<node> dropped = make_gc<node>(heap);
+            dropped->next = make_gc<node>(heap);
+            dropped->next->next = dropped;
+        }
+        CHECK(live == 5);
+
+        heap.collect();
+        CHECK(live == 3);
+        CHECK(kept->next->next->next.get() == kept.get());
+    }
+
+    // The reachable cycle is garbage once its root is gone.
+    heap.collect();
+    CHECK(live == 0);
+    CHECK(heap.bytes() == 0);
+}
+
+/// \brief Checks that objects allocated inside the constructor of another object survive collection steps.
+void test_nested_allocation()
+{
+    // A threshold of one byte runs collection work on every allocation.
+    gc_heap heap(1, 1000);
+    {
+        gc_ptr<pair> pairs[8];
+        for(int i = 0; i < 8; ++i)
+        {
+            pairs[i] = make_gc<pair>(heap, heap);
+        }
+        heap.collect();
+        CHECK(live == 24);
+        for(int i = 0; i < 8; ++i)
+        {
+            CHECK(pairs[i]->first->value == 1);
+            CHECK(pairs[i]->second->value == 2);
+        }
+    }
+    heap.collect();
+    CHECK(live == 0);
+
+    // Interleave nested allocations with incremental steps at every phase of a cycle.
+    for(size_t budget = 1; budget < 12; ++budget)
+    {
+        gc_heap stepped(1, budget);
+        gc_ptr<pair> kept = make_gc<pair>(stepped, stepped);
+        for(int i = 0; i < 32; ++i)
+        {
+            gc_ptr<pair> temporary = make_gc<pair>(stepped, stepped);
+            CHECK(temporary->first->value == 1);
+            CHECK(kept->second->value == 2);
+        }
+        stepped.collect();
+        CHECK(live == 3);
+    }
+    CHECK(live == 0);
+}
+
+int main()
+{
+    test_cycles();
+    test_nested_allocation();
+
+    if(failures)
+    {
+        std::printf("%d checks failed\n", failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
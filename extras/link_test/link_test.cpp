@@ -0,0 +1,179 @@
+/// \file link_test.cpp
+/// \brief Tests the iterative release of chains linked through unique_ptr_link and shared_ptr_link.
+/// \details Build and run on the host, preferably with the address sanitizer:
+///
+///     c++ -std=c++11 -g -fsanitize=address,undefined -Isrc -o link_test extras/link_test/link_test.cpp
+///     ./link_test
+///
+/// Prints each failed check and exits with a nonzero status if any check failed.
+#include <smart_ptr.hpp>
+
+#include <cstdio>
+
+/// \brief The number of failed checks.
+int failures = 0;
+
+/// \brief Records a failed check.
+#define CHECK(condition) do { if(!(condition)) { std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); ++failures; } } while(0)
+
+// TYPES
+/// \brief The number of live nodes.
+int live = 0;
+
+/// \brief A node of a singly linked list that owns its successor uniquely.
+struct unique_node
+{
+    /// \brief Creates a new node without a successor.
+    /// \param value The value of the node.
+    unique_node(int value = 0)
+        : value(value)
+    {
+        ++live;
+    }
+    ~unique_node()
+    {
+        --live;
+    }
+
+    /// \brief The value of the node.
+    int value;
+    /// \brief The successor of the node.
+    unique_ptr<unique_node> next;
+};
+
+/// \brief A node of a singly linked list that shares ownership of its successor.
+struct shared_node
+{
+    /// \brief Creates a new node without a successor.
+    /// \param value The value of the node.
+    shared_node(int value = 0)
+        : value(value)
+    {
+        ++live;
+    }
+    ~shared_node()
+    {
+        --live;
+    }
+
+    /// \brief The value of the node.
+    int value;
+    /// \brief The successor of the node.
+    shared_ptr<shared_node> next;
+};
+
+/// \brief Links unique_node instances through their next member.
+template <>
+struct unique_ptr_link<unique_node>
+{
+    /// \brief Gets the successor link of a node.
+    /// \param object The node.
+    /// \return A pointer to the successor link.
+    static unique_ptr<unique_node>* next(unique_node& object)
+    {
+        return &object.next;
+    }
+};
+
+/// \brief Links shared_node instances through their next member.
+template <>
+struct shared_ptr_link<shared_node>
+{
+    /// \brief Gets the successor link of a node.
+    /// \param object The node.
+    /// \return A pointer to the successor link.
+    static shared_ptr<shared_node>* next(shared_node& object)
+    {
+        return &object.next;
+    }
+};
+
+/// \brief The length of the long chains, enough to overflow the stack if released recursively.
+const int chain_length = 1000000;
+
+// TESTS
+/// \brief Releases a long chain of unique_nodes.
+void test_unique_chain()
+{
+    {
+        unique_ptr<unique_node> head;
+        for(int i = 0; i < chain_length; ++i)
+        {
+            unique_ptr<unique_node> node = make_unique<unique_node>(i);
+            node->next = static_cast<unique_ptr<unique_node>&&>(head);
+            head = static_cast<unique_ptr<unique_node>&&>(node);
+        }
+        CHECK(live == chain_length);
+    }
+    CHECK(live == 0);
+}
+
+/// \brief Releases a long chain of shared_nodes, keeping one node in the middle alive.
+void test_shared_chain()
+{
+    shared_ptr<shared_node> middle;
+    {
+        shared_ptr<shared_node> head;
+        for(int i = 0; i < chain_length; ++i)
+        {
+            shared_ptr<shared_node> node = make_shared<shared_node>(i);
+            node->next = head;
+            head = node;
+            if(i == chain_length / 2)
+            {
+                middle = node;
+            }
+        }
+        CHECK(live == chain_length);
+    }
+
+    // The release stops at the node still referenced, which keeps its own successors.
+    CHECK(live == chain_length / 2 + 1);
+    CHECK(middle->value == chain_length / 2);
+    middle.reset();
+    CHECK(live == 0);
+}
+
+/// \brief Pops the front of lists by move assigning the head from its own successor.
+void test_pop_front()
+{
+    unique_ptr<unique_node> unique_head;
+    shared_ptr<shared_node> shared_head;
+    for(int i = 0; i < 4; ++i)
+    {
+        unique_ptr<unique_node> unique = make_unique<unique_node>(i);
+        unique->next = static_cast<unique_ptr<unique_node>&&>(unique_head);
+        unique_head = static_cast<unique_ptr<unique_node>&&>(unique);
+
+        shared_ptr<shared_node> shared = make_shared<shared_node>(i);
+        shared->next = static_cast<shared_ptr<shared_node>&&>(shared_head);
+        shared_head = static_cast<shared_ptr<shared_node>&&>(shared);
+    }
+
+    // The old head owns the moved pointer and is destroyed by the assignment.
+    for(int i = 3; i >= 0; --i)
+    {
+        CHECK(unique_head && unique_head->value == i);
+        CHECK(shared_head && shared_head->value == i);
+        unique_head = static_cast<unique_ptr<unique_node>&&>(unique_head->next);
+        shared_head = static_cast<shared_ptr<shared_node>&&>(shared_head->next);
+        CHECK(live == 2 * i);
+    }
+    CHECK(!unique_head);
+    CHECK(!shared_head);
+}
+
+int main()
+{
+    test_unique_chain();
+    test_shared_chain();
+    test_pop_front();
+
+    if(failures)
+    {
+        std::printf("%d checks failed\n", failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
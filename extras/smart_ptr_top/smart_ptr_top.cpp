@@ -0,0 +1,129 @@
+/// \file smart_ptr_top.cpp
+/// \brief Displays the memory snapshots published by memory_telemetry in a running program.
+/// \details Build and run on the host:
+///
+///     c++ -std=c++11 -O2 -Isrc -o smart_ptr_top extras/smart_ptr_top/smart_ptr_top.cpp -pthread -lrt
+///     ./smart_ptr_top /my_program [--interval ms] [--once]
+///
+/// The name is the one passed to memory_telemetry::start() in the program, which must be built with the same
+/// SMART_PTR_TELEMETRY_TYPES. Shows the live objects and bytes of all types, the allocation rate, and one line per
+/// type sorted by live bytes, refreshed every interval until interrupted.
+#include <memory_telemetry.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/// \brief Prints a snapshot.
+/// \param pid The process id of the publisher.
+/// \param data The snapshot.
+void print_snapshot(uint32_t pid, const memory_telemetry::snapshot& data)
+{
+    std::printf("pid %u  snapshot %llu  live %llu objects, %llu bytes  allocating %.0f objects/s, %.0f bytes/s\n\n",
+                pid, static_cast<unsigned long long>(data.sequence), static_cast<unsigned long long>(data.live_objects),
+                static_cast<unsigned long long>(data.live_bytes), data.allocation_rate, data.byte_rate);
+
+    // Sort the types by live bytes.
+    std::vector<const memory_telemetry::type_snapshot*> types;
+    for(uint32_t i = 0; i < data.type_count; ++i)
+    {
+        if(data.types[i].allocations)
+        {
+            types.push_back(&data.types[i]);
+        }
+    }
+    std::sort(types.begin(), types.end(), [](const memory_telemetry::type_snapshot* a, const memory_telemetry::type_snapshot* b)
+    {
+        return a->live_bytes > b->live_bytes;
+    });
+
+    std::printf("%14s %14s %14s %16s  %s\n", "LIVE BYTES", "LIVE OBJECTS", "ALLOCATIONS", "ALLOCATED BYTES", "TYPE");
+    for(const memory_telemetry::type_snapshot* type : types)
+    {
+        std::printf("%14llu %14llu %14llu %16llu  %s\n", static_cast<unsigned long long>(type->live_bytes),
+                    static_cast<unsigned long long>(type->live_objects), static_cast<unsigned long long>(type->allocations),
+                    static_cast<unsigned long long>(type->allocated_bytes), type->name);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    // Parse the arguments.
+    const char* name = nullptr;
+    unsigned interval = 1000;
+    bool once = false;
+    for(int i = 1; i < argc; ++i)
+    {
+        if(std::strcmp(argv[i], "--interval") == 0 && i + 1 < argc)
+        {
+            interval = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 0));
+        }
+        else if(std::strcmp(argv[i], "--once") == 0)
+        {
+            once = true;
+        }
+        else
+        {
+            name = argv[i];
+        }
+    }
+    if(!name)
+    {
+        std::fprintf(stderr, "usage: %s name [--interval ms] [--once]\n", argv[0]);
+        return 2;
+    }
+
+    // Map the shared memory read-only.
+    int descriptor = shm_open(name, O_RDONLY, 0);
+    if(descriptor < 0)
+    {
+        std::fprintf(stderr, "%s: cannot open shared memory %s\n", argv[0], name);
+        return 1;
+    }
+    void* mapping = mmap(nullptr, sizeof(memory_telemetry::region), PROT_READ, MAP_SHARED, descriptor, 0);
+    close(descriptor);
+    if(mapping == MAP_FAILED)
+    {
+        std::fprintf(stderr, "%s: cannot map shared memory %s\n", argv[0], name);
+        return 1;
+    }
+    const memory_telemetry::region& shared = *static_cast<const memory_telemetry::region*>(mapping);
+    if(shared.magic.load(std::memory_order_acquire) != memory_telemetry::magic || shared.type_capacity != SMART_PTR_TELEMETRY_TYPES)
+    {
+        std::fprintf(stderr, "%s: %s is not a telemetry region of this version\n", argv[0], name);
+        return 1;
+    }
+
+    // Display the latest snapshot until interrupted.
+    memory_telemetry::snapshot data;
+    while(true)
+    {
+        if(!once)
+        {
+            std::printf("\033[H\033[2J");
+        }
+        if(memory_telemetry::read(shared, data))
+        {
+            print_snapshot(shared.pid, data);
+        }
+        else
+        {
+            std::printf("pid %u  waiting for the first snapshot\n", shared.pid);
+        }
+        std::fflush(stdout);
+        if(once)
+        {
+            return 0;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(interval));
+    }
+}
@@ -0,0 +1,623 @@
+/// \file trace_replay.cpp
+/// \brief Replays an allocation trace recorded by allocation_trace against allocator models.
+/// \details Build and run on the host:
+///
+///     c++ -std=c++17 -O2 -o trace_replay extras/trace_replay/trace_replay.cpp
+///     ./trace_replay trace.bin [--heap-limit bytes]
+///
+/// For each model, reports the peak footprint, the overhead over the peak live bytes, the number of failed
+/// allocations when a heap limit is given, the average number of free chunks searched per allocation as a proxy for
+/// time on the device, and the host time per operation.
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// TRACE
+/// \brief A record of the trace.
+struct event
+{
+    /// \brief TRUE for an allocation, FALSE for a free.
+    bool allocate;
+    /// \brief The microseconds since the previous record.
+    uint64_t elapsed;
+    /// \brief The address of the allocation.
+    uint64_t address;
+    /// \brief The size of the allocation in bytes, for allocations.
+    uint64_t size;
+    /// \brief The type index of the allocation, for allocations.
+    uint64_t type;
+};
+
+/// \brief Reads a trace file.
+class trace_reader
+{
+public:
+    /// \brief Reads and decodes a trace file.
+    /// \param path The path of the trace file.
+    /// \return TRUE if the file was read, otherwise FALSE.
+    bool read(const char* path)
+    {
+        FILE* file = std::fopen(path, "rb");
+        if(!file)
+        {
+            std::fprintf(stderr, "cannot open %s\n", path);
+            return false;
+        }
+        int c;
+        while((c = std::fgetc(file)) != EOF)
+        {
+            trace_reader::m_data.push_back(static_cast<uint8_t>(c));
+        }
+        std::fclose(file);
+
+        // Check the magic bytes.
+        if(trace_reader::m_data.size() < 4 || std::memcmp(trace_reader::m_data.data(), "SPT1", 4) != 0)
+        {
+            std::fprintf(stderr, "%s is not an allocation trace\n", path);
+            return false;
+        }
+        trace_reader::m_position = 4;
+
+        // Decode the records. A truncated final record is ignored.
+        while(trace_reader::m_position < trace_reader::m_data.size())
+        {
+            uint8_t tag = trace_reader::m_data[trace_reader::m_position++];
+            event current = {};
+            if(tag == 'T')
+            {
+                uint64_t index;
+                if(!trace_reader::decode(index) || trace_reader::m_position >= trace_reader::m_data.size())
+                {
+                    break;
+                }
+                size_t length = trace_reader::m_data[trace_reader::m_position++];
+                if(trace_reader::m_position + length > trace_reader::m_data.size())
+                {
+                    break;
+                }
+                trace_reader::types[index].assign(reinterpret_cast<const char*>(&trace_reader::m_data[trace_reader::m_position]), length);
+                trace_reader::m_position += length;
+            }
+            else if(tag == 'A')
+            {
+                current.allocate = true;
+                if(!trace_reader::decode(current.elapsed) || !trace_reader::decode(current.address) ||
+                   !trace_reader::decode(current.size) || !trace_reader::decode(current.type))
+                {
+                    break;
+                }
+                trace_reader::events.push_back(current);
+            }
+            else if(tag == 'F')
+            {
+                if(!trace_reader::decode(current.elapsed) || !trace_reader::decode(current.address))
+                {
+                    break;
+                }
+                trace_reader::events.push_back(current);
+            }
+            else
+            {
+                std::fprintf(stderr, "unknown record 0x%02x at offset %zu\n", tag, trace_reader::m_position - 1);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// \brief The decoded allocation and free records.
+    std::vector<event> events;
+    /// \brief The names of the types by index.
+    std::map<uint64_t, std::string> types;
+
+private:
+    /// \brief The contents of the trace file.
+    std::vector<uint8_t> m_data;
+    /// \brief The offset of the next byte to decode.
+    size_t m_position = 0;
+
+    /// \brief Decodes a LEB128 varint.
+    /// \param value The decoded value.
+    /// \return TRUE if a complete varint was decoded, otherwise FALSE.
+    bool decode(uint64_t& value)
+    {
+        value = 0;
+        for(unsigned shift = 0; trace_reader::m_position < trace_reader::m_data.size() && shift < 64; shift += 7)
+        {
+            uint8_t byte = trace_reader::m_data[trace_reader::m_position++];
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if(!(byte & 0x80))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+// MODELS
+/// \brief An allocator strategy that a trace is replayed against.
+class allocator_model
+{
+public:
+    virtual ~allocator_model() = default;
+    /// \brief Gets the name of the model.
+    /// \return The name.
+    virtual const char* name() const = 0;
+    /// \brief Allocates a block.
+    /// \param id The address of the allocation in the trace.
+    /// \param size The size of the allocation in bytes.
+    /// \return TRUE if the allocation succeeded, or FALSE if it exceeded the heap limit.
+    virtual bool allocate(uint64_t id, size_t size) = 0;
+    /// \brief Frees a block allocated by allocate().
+    /// \param id The address of the allocation in the trace.
+    virtual void free(uint64_t id) = 0;
+    /// \brief Gets the number of bytes the allocator currently reserves, or 0 if it cannot be measured.
+    /// \return The footprint in bytes.
+    virtual size_t footprint() const = 0;
+    /// \brief Gets the number of free chunks searched so far.
+    /// \return The number of chunks searched, or 0 if the model does not search.
+    virtual uint64_t searched() const
+    {
+        return 0;
+    }
+};
+
+/// \brief The host's malloc, for timing. Its footprint is not measured.
+class malloc_model
+    : public allocator_model
+{
+public:
+    ~malloc_model() override
+    {
+        for(auto& block : malloc_model::m_blocks)
+        {
+            std::free(block.second);
+        }
+    }
+    const char* name() const override
+    {
+        return "host malloc";
+    }
+    bool allocate(uint64_t id, size_t size) override
+    {
+        void* block = std::malloc(size ? size : 1);
+        malloc_model::m_blocks[id] = block;
+        return block != nullptr;
+    }
+    void free(uint64_t id) override
+    {
+        auto block = malloc_model::m_blocks.find(id);
+        std::free(block->second);
+        malloc_model::m_blocks.erase(block);
+    }
+    size_t footprint() const override
+    {
+        return 0;
+    }
+
+private:
+    /// \brief The live blocks by trace address.
+    std::unordered_map<uint64_t, void*> m_blocks;
+};
+
+/// \brief A model of avr-libc's malloc: an address-ordered free list searched for the best fit, with 2-byte chunk
+/// headers, allocation from the top of split chunks, coalescing on free, and a break that grows and shrinks. Since
+/// free() lowers the break over a free chunk at the top of the heap, no free chunk touches the break when malloc()
+/// grows the heap.
+class avr_libc_model
+    : public allocator_model
+{
+public:
+    /// \brief Creates a new avr_libc_model instance.
+    /// \param limit The maximum size of the heap in bytes, or 0 for no limit.
+    avr_libc_model(size_t limit)
+        : m_limit(limit)
+    {}
+    const char* name() const override
+    {
+        return "avr-libc malloc";
+    }
+    bool allocate(uint64_t id, size_t size) override
+    {
+        // Chunks must be able to hold a free list entry once freed.
+        if(size < avr_libc_model::minimum)
+        {
+            size = avr_libc_model::minimum;
+        }
+
+        // Search for an exact fit, or else the smallest chunk that fits.
+        auto best = avr_libc_model::m_free.end();
+        for(auto chunk = avr_libc_model::m_free.begin(); chunk != avr_libc_model::m_free.end(); ++chunk)
+        {
+            ++avr_libc_model::m_searched;
+            if(chunk->second == size)
+            {
+                best = chunk;
+                break;
+            }
+            if(chunk->second > size && (best == avr_libc_model::m_free.end() || chunk->second < best->second))
+            {
+                best = chunk;
+            }
+        }
+        if(best != avr_libc_model::m_free.end())
+        {
+            size_t address = best->first;
+            size_t chunk_size = best->second;
+            if(chunk_size - size < avr_libc_model::header + avr_libc_model::minimum)
+            {
+                // Hand out the whole chunk.
+                avr_libc_model::m_free.erase(best);
+                avr_libc_model::m_blocks[id] = {address, chunk_size};
+            }
+            else
+            {
+                // Split the chunk, handing out its top part.
+                best->second = chunk_size - size - avr_libc_model::header;
+                avr_libc_model::m_blocks[id] = {address + avr_libc_model::header + best->second, size};
+            }
+            return true;
+        }
+
+        // Grow the heap.
+        if(avr_libc_model::m_limit && avr_libc_model::m_break + avr_libc_model::header + size > avr_libc_model::m_limit)
+        {
+            return false;
+        }
+        avr_libc_model::m_blocks[id] = {avr_libc_model::m_break, size};
+        avr_libc_model::m_break += avr_libc_model::header + size;
+        return true;
+    }
+    void free(uint64_t id) override
+    {
+        auto block = avr_libc_model::m_blocks.find(id);
+        size_t address = block->second.first;
+        size_t size = block->second.second;
+        avr_libc_model::m_blocks.erase(block);
+
+        // Insert the chunk in address order and coalesce it with its neighbours.
+        auto chunk = avr_libc_model::m_free.emplace(address, size).first;
+        auto next = std::next(chunk);
+        if(next != avr_libc_model::m_free.end() && chunk->first + avr_libc_model::header + chunk->second == next->first)
+        {
+            chunk->second += avr_libc_model::header + next->second;
+            avr_libc_model::m_free.erase(next);
+        }
+        if(chunk != avr_libc_model::m_free.begin())
+        {
+            auto previous = std::prev(chunk);
+            if(previous->first + avr_libc_model::header + previous->second == chunk->first)
+            {
+                previous->second += avr_libc_model::header + chunk->second;
+                avr_libc_model::m_free.erase(chunk);
+                chunk = previous;
+            }
+        }
+
+        // Lower the break over a free chunk at the top of the heap.
+        if(chunk->first + avr_libc_model::header + chunk->second == avr_libc_model::m_break)
+        {
+            avr_libc_model::m_break = chunk->first;
+            avr_libc_model::m_free.erase(chunk);
+        }
+    }
+    size_t footprint() const override
+    {
+        return avr_libc_model::m_break;
+    }
+    uint64_t searched() const override
+    {
+        return avr_libc_model::m_searched;
+    }
+
+private:
+    /// \brief The size of a chunk header, which is a size_t on AVR.
+    static const size_t header = 2;
+    /// \brief The minimum chunk size, which holds the free list's next pointer.
+    static const size_t minimum = 2;
+    /// \brief The maximum size of the heap in bytes, or 0 for no limit.
+    size_t m_limit;
+    /// \brief The offset of the break from the start of the heap.
+    size_t m_break = 0;
+    /// \brief The free chunks, as offset of the header to size of the payload, in address order.
+    std::map<size_t, size_t> m_free;
+    /// \brief The live blocks by trace address, as offset of the header and size of the payload.
+    std::unordered_map<uint64_t, std::pair<size_t, size_t>> m_blocks;
+    /// \brief The number of free chunks searched.
+    uint64_t m_searched = 0;
+};
+
+/// \brief Segregated pools of power-of-two size classes carved from fixed pages, which are never returned.
+/// Allocations larger than a page get their own block.
+class pool_model
+    : public allocator_model
+{
+public:
+    /// \brief Creates a new pool_model instance.
+    /// \param limit The maximum footprint in bytes, or 0 for no limit.
+    pool_model(size_t limit)
+        : m_limit(limit)
+    {}
+    const char* name() const override
+    {
+        return "pools (256 B pages)";
+    }
+    bool allocate(uint64_t id, size_t size) override
+    {
+        // Give large allocations their own block.
+        if(size > pool_model::page / 2)
+        {
+            if(pool_model::m_limit && pool_model::m_footprint + size > pool_model::m_limit)
+            {
+                return false;
+            }
+            pool_model::m_footprint += size;
+            pool_model::m_blocks[id] = {size_t(-1), size};
+            return true;
+        }
+
+        // Find the size class.
+        size_t index = 0;
+        size_t class_size = pool_model::smallest;
+        while(class_size < size)
+        {
+            class_size *= 2;
+            ++index;
+        }
+
+        // Carve a new page when the class has no free blocks.
+        if(pool_model::m_available[index] == 0)
+        {
+            if(pool_model::m_limit && pool_model::m_footprint + pool_model::page > pool_model::m_limit)
+            {
+                return false;
+            }
+            pool_model::m_footprint += pool_model::page;
+            pool_model::m_available[index] += pool_model::page / class_size;
+        }
+        --pool_model::m_available[index];
+        pool_model::m_blocks[id] = {index, size};
+        return true;
+    }
+    void free(uint64_t id) override
+    {
+        auto block = pool_model::m_blocks.find(id);
+        if(block->second.first == size_t(-1))
+        {
+            pool_model::m_footprint -= block->second.second;
+        }
+        else
+        {
+            ++pool_model::m_available[block->second.first];
+        }
+        pool_model::m_blocks.erase(block);
+    }
+    size_t footprint() const override
+    {
+        return pool_model::m_footprint;
+    }
+
+private:
+    /// \brief The size of a page in bytes.
+    static const size_t page = 256;
+    /// \brief The smallest size class in bytes.
+    static const size_t smallest = 4;
+    /// \brief The maximum footprint in bytes, or 0 for no limit.
+    size_t m_limit;
+    /// \brief The bytes reserved by pages and large blocks.
+    size_t m_footprint = 0;
+    /// \brief The number of free blocks in each size class.
+    size_t m_available[8] = {};
+    /// \brief The live blocks by trace address, as size class (or -1 for large blocks) and size.
+    std::unordered_map<uint64_t, std::pair<size_t, size_t>> m_blocks;
+};
+
+/// \brief A bump allocator that only reclaims memory when every allocation has been freed.
+class arena_model
+    : public allocator_model
+{
+public:
+    /// \brief Creates a new arena_model instance.
+    /// \param limit The maximum size of the arena in bytes, or 0 for no limit.
+    arena_model(size_t limit)
+        : m_limit(limit)
+    {}
+    const char* name() const override
+    {
+        return "arena";
+    }
+    bool allocate(uint64_t id, size_t size) override
+    {
+        if(arena_model::m_limit && arena_model::m_top + size > arena_model::m_limit)
+        {
+            return false;
+        }
+        arena_model::m_top += size;
+        arena_model::m_live.emplace(id);
+        return true;
+    }
+    void free(uint64_t id) override
+    {
+        arena_model::m_live.erase(id);
+        if(arena_model::m_live.empty())
+        {
+            arena_model::m_top = 0;
+        }
+    }
+    size_t footprint() const override
+    {
+        return arena_model::m_top;
+    }
+
+private:
+    /// \brief The maximum size of the arena in bytes, or 0 for no limit.
+    size_t m_limit;
+    /// \brief The offset of the end of the last allocation.
+    size_t m_top = 0;
+    /// \brief The live allocations by trace address.
+    std::unordered_set<uint64_t> m_live;
+};
+
+// REPLAY
+/// \brief The results of replaying a trace against a model.
+struct replay_result
+{
+    /// \brief The largest footprint reached.
+    size_t peak_footprint = 0;
+    /// \brief The number of allocations that exceeded the heap limit.
+    uint64_t failures = 0;
+    /// \brief The number of allocations and frees replayed.
+    uint64_t operations = 0;
+    /// \brief The host time spent in the model in nanoseconds.
+    double nanoseconds = 0;
+};
+
+/// \brief Replays the events of a trace against a model.
+/// \param events The events of the trace.
+/// \param model The model.
+/// \return The results of the replay.
+replay_result replay(const std::vector<event>& events, allocator_model& model)
+{
+    replay_result result;
+    std::unordered_map<uint64_t, bool> live;
+
+    auto start = std::chrono::steady_clock::now();
+    for(const event& current : events)
+    {
+        if(current.allocate)
+        {
+            // An allocation at a live address means the free was not recorded; free it first.
+            if(live.count(current.address))
+            {
+                model.free(current.address);
+                live.erase(current.address);
+            }
+            if(model.allocate(current.address, current.size))
+            {
+                live[current.address] = true;
+            }
+            else
+            {
+                ++result.failures;
+            }
+        }
+        else if(live.erase(current.address))
+        {
+            model.free(current.address);
+        }
+        ++result.operations;
+        if(model.footprint() > result.peak_footprint)
+        {
+            result.peak_footprint = model.footprint();
+        }
+    }
+    result.nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    // Parse the arguments.
+    const char* path = nullptr;
+    size_t limit = 0;
+    for(int i = 1; i < argc; ++i)
+    {
+        if(std::strcmp(argv[i], "--heap-limit") == 0 && i + 1 < argc)
+        {
+            limit = std::strtoull(argv[++i], nullptr, 0);
+        }
+        else
+        {
+            path = argv[i];
+        }
+    }
+    if(!path)
+    {
+        std::fprintf(stderr, "usage: %s trace.bin [--heap-limit bytes]\n", argv[0]);
+        return 2;
+    }
+
+    trace_reader trace;
+    if(!trace.read(path))
+    {
+        return 1;
+    }
+
+    // Summarize the trace per type, and find the peak live bytes.
+    struct type_summary
+    {
+        uint64_t allocations = 0;
+        uint64_t bytes = 0;
+    };
+    std::map<uint64_t, type_summary> summaries;
+    std::unordered_map<uint64_t, uint64_t> live;
+    uint64_t live_bytes = 0;
+    uint64_t peak_live_bytes = 0;
+    uint64_t duration = 0;
+    for(const event& current : trace.events)
+    {
+        duration += current.elapsed;
+        if(current.allocate)
+        {
+            ++summaries[current.type].allocations;
+            summaries[current.type].bytes += current.size;
+            live_bytes -= live[current.address];
+            live[current.address] = current.size;
+            live_bytes += current.size;
+            peak_live_bytes = live_bytes > peak_live_bytes ? live_bytes : peak_live_bytes;
+        }
+        else
+        {
+            auto block = live.find(current.address);
+            if(block != live.end())
+            {
+                live_bytes -= block->second;
+                live.erase(block);
+            }
+        }
+    }
+    std::printf("%zu events over %.3f s, peak live %llu bytes\n\n", trace.events.size(), duration / 1e6, static_cast<unsigned long long>(peak_live_bytes));
+    std::printf("%-40s %12s %12s\n", "type", "allocations", "bytes");
+    for(auto& summary : summaries)
+    {
+        auto name = trace.types.find(summary.first);
+        std::printf("%-40.40s %12llu %12llu\n", name != trace.types.end() ? name->second.c_str() : "?",
+                    static_cast<unsigned long long>(summary.second.allocations), static_cast<unsigned long long>(summary.second.bytes));
+    }
+
+    // Replay against each model.
+    std::vector<std::unique_ptr<allocator_model>> models;
+    models.emplace_back(new malloc_model());
+    models.emplace_back(new avr_libc_model(limit));
+    models.emplace_back(new pool_model(limit));
+    models.emplace_back(new arena_model(limit));
+    std::printf("\n%-22s %14s %10s %10s %14s %10s\n", "model", "peak bytes", "overhead", "failures", "searched/op", "ns/op");
+    for(auto& model : models)
+    {
+        replay_result result = replay(trace.events, *model);
+        double operations = result.operations ? static_cast<double>(result.operations) : 1.0;
+        if(result.peak_footprint)
+        {
+            std::printf("%-22s %14zu %9.1f%% %10llu %14.2f %10.1f\n", model->name(), result.peak_footprint,
+                        peak_live_bytes ? 100.0 * (static_cast<double>(result.peak_footprint) / peak_live_bytes - 1.0) : 0.0,
+                        static_cast<unsigned long long>(result.failures), model->searched() / operations, result.nanoseconds / operations);
+        }
+        else
+        {
+            std::printf("%-22s %14s %10s %10llu %14s %10.1f\n", model->name(), "-", "-",
+                        static_cast<unsigned long long>(result.failures), "-", result.nanoseconds / operations);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,357 @@
+/// \file allocation_profiler.hpp
+/// \brief Defines the allocation_profiler class.
+#ifndef SMART_PTR___ALLOCATION_PROFILER_H
+#define SMART_PTR___ALLOCATION_PROFILER_H
+
+#ifndef ARDUINO
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifdef SMART_PTR_PROFILE_NO_STACKS
+#undef SMART_PTR_PROFILE_STACKS
+#elif defined(__has_include)
+#if __has_include(<execinfo.h>) && __has_include(<dlfcn.h>) && __has_include(<cxxabi.h>)
+#include <execinfo.h>
+#include <dlfcn.h>
+#include <cxxabi.h>
+#ifndef SMART_PTR_PROFILE_STACKS
+#define SMART_PTR_PROFILE_STACKS
+#endif
+#endif
+#endif
+
+/// \brief Samples the allocations made by the smart pointers and records their call stacks, for finding the call
+/// paths that retain the most memory in production.
+/// \details Enabled by defining SMART_PTR_PROFILE before including the library, on hosted builds only. About one
+/// allocation is sampled per interval bytes: the distance to the next sample is drawn from an exponential
+/// distribution, so allocations of every size are sampled without bias, and each sample is weighted by the inverse
+/// of its sampling probability. Profiles of live and cumulative memory are written in pprof's legacy heap format or
+/// as collapsed stacks for flame graphs. Stacks are captured with backtrace() where it is available; link with
+/// -rdynamic so that collapsed stacks show function names instead of addresses. Define SMART_PTR_PROFILE_NO_STACKS
+/// to skip stack capture, so that samples are only attributed by size.
+class allocation_profiler
+{
+public:
+    // CONFIGURATION
+    /// \brief Sets the mean number of bytes allocated between samples.
+    /// \param interval The sampling interval in bytes. Smaller intervals are more accurate and more expensive.
+    static void set_interval(size_t interval)
+    {
+        state& profiler = allocation_profiler::get_state();
+        std::lock_guard<std::mutex> lock(profiler.mutex);
+        profiler.interval = interval ? interval : 1;
+        profiler.countdown = allocation_profiler::next_sample(profiler);
+    }
+
+    // HOOKS
+    /// \brief Counts an allocation, and samples it if the sampling interval has elapsed.
+    /// \param address The address of the allocation.
+    /// \param size The size of the allocation in bytes.
+    static void allocate(const void* address, size_t size)
+    {
+        state& profiler = allocation_profiler::get_state();
+        std::lock_guard<std::mutex> lock(profiler.mutex);
+
+        // Count down to the next sample.
+        if(size < profiler.countdown)
+        {
+            profiler.countdown -= size;
+            return;
+        }
+        profiler.countdown = allocation_profiler::next_sample(profiler);
+
+        // Capture the call stack and find or add its bucket.
+        bucket_key key;
+#ifdef SMART_PTR_PROFILE_STACKS
+        void* frames[allocation_profiler::max_depth];
+        int depth = backtrace(frames, allocation_profiler::max_depth);
+        for(int i = allocation_profiler::skipped_frames; i < depth; ++i)
+        {
+            key.push_back(reinterpret_cast<uintptr_t>(frames[i]));
+        }
+#endif
+        size_t index = allocation_profiler::find_bucket(profiler, key);
+
+        // Weight the sample by the inverse of the probability that an allocation of its size is sampled.
+        double probability = 1.0 - exp(-static_cast<double>(size) / static_cast<double>(profiler.interval));
+        double count = 1.0 / probability;
+        double bytes = size / probability;
+        bucket& sampled = profiler.buckets[index];
+        sampled.allocated_count += count;
+        sampled.allocated_bytes += bytes;
+        sampled.live_count += count;
+        sampled.live_bytes += bytes;
+        profiler.live[address] = {index, count, bytes};
+    }
+    /// \brief Removes a freed allocation from the live profile if it was sampled.
+    /// \param address The address of the allocation.
+    static void free(const void* address)
+    {
+        state& profiler = allocation_profiler::get_state();
+        std::lock_guard<std::mutex> lock(profiler.mutex);
+
+        auto sample = profiler.live.find(address);
+        if(sample != profiler.live.end())
+        {
+            bucket& sampled = profiler.buckets[sample->second.bucket];
+            sampled.live_count -= sample->second.count;
+            sampled.live_bytes -= sample->second.bytes;
+            profiler.live.erase(sample);
+        }
+    }
+
+    // OUTPUT
+    /// \brief Writes the live and cumulative profiles in pprof's legacy heap profile format.
+    /// \details View with "pprof <binary> <file>". The counts are written already scaled, with a sampling rate of 1;
+    /// -sample_index=inuse_space or alloc_space selects between the live and cumulative values.
+    /// \param path The path of the file to write.
+    /// \return TRUE if the file was written, otherwise FALSE.
+    static bool write_pprof(const char* path)
+    {
+        FILE* file = fopen(path, "w");
+        if(!file)
+        {
+            return false;
+        }
+
+        state& profiler = allocation_profiler::get_state();
+        {
+            std::lock_guard<std::mutex> lock(profiler.mutex);
+
+            // Write the totals, then one line per call stack.
+            bucket total = {};
+            for(const bucket& current : profiler.buckets)
+            {
+                total.live_count += current.live_count;
+                total.live_bytes += current.live_bytes;
+                total.allocated_count += current.allocated_count;
+                total.allocated_bytes += current.allocated_bytes;
+            }
+            // The counts are already weighted by the inverse sampling probability, so declare a sampling rate of 1,
+            // which tells pprof not to scale them again.
+            fprintf(file, "heap profile: ");
+            allocation_profiler::write_counts(file, total);
+            fprintf(file, " @ heap_v2/1\n");
+            for(const bucket& current : profiler.buckets)
+            {
+                allocation_profiler::write_counts(file, current);
+                fprintf(file, " @");
+                for(uintptr_t frame : current.key)
+                {
+                    fprintf(file, " 0x%llx", static_cast<unsigned long long>(frame));
+                }
+                fprintf(file, "\n");
+            }
+        }
+
+        // Append the memory map so that pprof can symbolize the addresses.
+        fprintf(file, "\nMAPPED_LIBRARIES:\n");
+        FILE* maps = fopen("/proc/self/maps", "r");
+        if(maps)
+        {
+            char buffer[4096];
+            size_t read;
+            while((read = fread(buffer, 1, sizeof(buffer), maps)) != 0)
+            {
+                fwrite(buffer, 1, read, file);
+            }
+            fclose(maps);
+        }
+
+        return fclose(file) == 0;
+    }
+    /// \brief Writes a profile as collapsed stacks, one "root;...;leaf bytes" line per call stack.
+    /// \details The output can be rendered by flamegraph.pl or speedscope.
+    /// \param path The path of the file to write.
+    /// \param live TRUE to write the live bytes, or FALSE to write the cumulative allocated bytes.
+    /// \return TRUE if the file was written, otherwise FALSE.
+    static bool write_collapsed(const char* path, bool live = true)
+    {
+        FILE* file = fopen(path, "w");
+        if(!file)
+        {
+            return false;
+        }
+
+        state& profiler = allocation_profiler::get_state();
+        std::lock_guard<std::mutex> lock(profiler.mutex);
+        for(const bucket& current : profiler.buckets)
+        {
+            double bytes = live ? current.live_bytes : current.allocated_bytes;
+            if(bytes < 0.5)
+            {
+                continue;
+            }
+
+            // Write the frames from the root to the leaf.
+            if(current.key.empty())
+            {
+                fprintf(file, "[unknown]");
+            }
+            for(size_t i = current.key.size(); i > 0; --i)
+            {
+                fprintf(file, "%s%s", allocation_profiler::symbol(current.key[i - 1]).c_str(), i > 1 ? ";" : "");
+            }
+            fprintf(file, " %.0f\n", bytes);
+        }
+
+        return fclose(file) == 0;
+    }
+
+private:
+    // TYPES
+    /// \brief The return addresses of a call stack, from the leaf to the root.
+    typedef std::vector<uintptr_t> bucket_key;
+    /// \brief The estimated allocations of a call stack.
+    struct bucket
+    {
+        /// \brief The call stack.
+        bucket_key key;
+        /// \brief The estimated number of live objects.
+        double live_count;
+        /// \brief The estimated number of live bytes.
+        double live_bytes;
+        /// \brief The estimated number of objects allocated.
+        double allocated_count;
+        /// \brief The estimated number of bytes allocated.
+        double allocated_bytes;
+    };
+    /// \brief A live sampled allocation.
+    struct sample
+    {
+        /// \brief The index of the bucket of its call stack.
+        size_t bucket;
+        /// \brief The weighted count of the sample.
+        double count;
+        /// \brief The weighted bytes of the sample.
+        double bytes;
+    };
+    /// \brief Hashes a call stack.
+    struct bucket_hash
+    {
+        /// \brief Hashes a call stack.
+        /// \param key The call stack.
+        /// \return The hash.
+        size_t operator()(const bucket_key& key) const
+        {
+            size_t hash = 0;
+            for(uintptr_t frame : key)
+            {
+                hash = hash * 31 + static_cast<size_t>(frame);
+            }
+            return hash;
+        }
+    };
+
+    // STATE
+    /// \brief The maximum number of frames captured per sample.
+    static const int max_depth = 64;
+    /// \brief The number of frames captured inside the profiler and hooks, which are left out of the stacks.
+    static const int skipped_frames = 2;
+    /// \brief The state of the profiler.
+    struct state
+    {
+        /// \brief The mean number of bytes between samples.
+        size_t interval = 512 * 1024;
+        /// \brief The number of bytes left until the next sample.
+        size_t countdown = 512 * 1024;
+        /// \brief The state of the random number generator.
+        uint64_t random = 0x9E3779B97F4A7C15ull;
+        /// \brief The buckets of the sampled call stacks.
+        std::vector<bucket> buckets;
+        /// \brief The indices of the buckets by call stack.
+        std::unordered_map<bucket_key, size_t, bucket_hash> indices;
+        /// \brief The live sampled allocations by address.
+        std::unordered_map<const void*, sample> live;
+        /// \brief Serializes the profiler across threads.
+        std::mutex mutex;
+    };
+    /// \brief Gets the state of the profiler.
+    /// \return A reference to the state.
+    static state& get_state()
+    {
+        static state profiler;
+        return profiler;
+    }
+
+    // SAMPLING
+    /// \brief Draws the number of bytes until the next sample from an exponential distribution.
+    /// \param profiler The state.
+    /// \return The number of bytes until the next sample.
+    static size_t next_sample(state& profiler)
+    {
+        // Advance the xorshift generator and map it to a uniform value in (0, 1].
+        profiler.random ^= profiler.random << 13;
+        profiler.random ^= profiler.random >> 7;
+        profiler.random ^= profiler.random << 17;
+        double uniform = (static_cast<double>(profiler.random >> 11) + 1.0) / 9007199254740992.0;
+
+        return static_cast<size_t>(-log(uniform) * static_cast<double>(profiler.interval)) + 1;
+    }
+    /// \brief Finds the bucket of a call stack, adding it if it does not exist.
+    /// \param profiler The state.
+    /// \param key The call stack.
+    /// \return The index of the bucket.
+    static size_t find_bucket(state& profiler, const bucket_key& key)
+    {
+        auto found = profiler.indices.find(key);
+        if(found != profiler.indices.end())
+        {
+            return found->second;
+        }
+        profiler.buckets.push_back({key, 0, 0, 0, 0});
+        profiler.indices[key] = profiler.buckets.size() - 1;
+        return profiler.buckets.size() - 1;
+    }
+
+    // OUTPUT
+    /// \brief Writes the counts of a bucket as "live_count: live_bytes [allocated_count: allocated_bytes]".
+    /// \param file The file to write to.
+    /// \param counts The bucket.
+    static void write_counts(FILE* file, const bucket& counts)
+    {
+        fprintf(file, "%.0f: %.0f [%.0f: %.0f]", counts.live_count, counts.live_bytes, counts.allocated_count, counts.allocated_bytes);
+    }
+    /// \brief Gets the name of the function containing a return address.
+    /// \param frame The return address.
+    /// \return The demangled function name, or the address in hexadecimal if it cannot be resolved.
+    static std::string symbol(uintptr_t frame)
+    {
+#ifdef SMART_PTR_PROFILE_STACKS
+        Dl_info info;
+        if(dladdr(reinterpret_cast<void*>(frame), &info) && info.dli_sname)
+        {
+            int status = 0;
+            char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+            std::string name = status == 0 ? demangled : info.dli_sname;
+            ::free(demangled);
+
+            // Keep the separators of the collapsed format out of the name.
+            for(char& c : name)
+            {
+                if(c == ';' || c == ' ')
+                {
+                    c = '_';
+                }
+            }
+            return name;
+        }
+#endif
+        char address[2 + 2 * sizeof(uintptr_t) + 1];
+        snprintf(address, sizeof(address), "0x%llx", static_cast<unsigned long long>(frame));
+        return address;
+    }
+};
+
+#endif
+
+#endif
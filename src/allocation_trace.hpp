@@ -0,0 +1,274 @@
+/// \file allocation_trace.hpp
+/// \brief Defines the allocation_trace class.
+#ifndef SMART_PTR___ALLOCATION_TRACE_H
+#define SMART_PTR___ALLOCATION_TRACE_H
+
+#include <smart_ptr_clock.hpp>
+#include <smart_ptr_type.hpp>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef ARDUINO
+#include <mutex>
+#include <stdio.h>
+#endif
+
+/// \brief Records every allocation and free made by the smart pointers into a compact binary trace.
+/// \details Enabled by defining SMART_PTR_TRACE before including the library. The trace starts with the magic bytes
+/// "SPT1", followed by records that each start with a one-byte tag. Integers are unsigned LEB128 varints:
+/// - 'T' type: index, name length (one byte), name characters. Written before the first allocation of the type.
+/// - 'A' allocate: microseconds since the previous record, address, size in bytes, type index.
+/// - 'F' free: microseconds since the previous record, address.
+///
+/// Sizes are those of the allocations made by the library: objects, separately allocated counts, arrays created by
+/// make_unique(), and the combined allocations of make_shared_n(), make_shared_trailing(), and
+/// make_unique_trailing(). extras/trace_replay replays a trace against allocator models. Allocations made by the
+/// writer itself, such as those of a buffered sink using the smart pointers, are not recorded.
+class allocation_trace
+{
+public:
+    // TYPES
+    /// \brief The type of a function that writes trace data, for example to a file or a serial port.
+    typedef void (*writer_type)(const uint8_t* data, size_t size, void* context);
+
+    // CONTROL
+    /// \brief Starts recording into a writer.
+    /// \param writer The function that writes the trace data.
+    /// \param context The context passed to the writer.
+    static void start(writer_type writer, void* context)
+    {
+        state& trace = allocation_trace::get_state();
+        allocation_trace::lock(trace);
+        trace.writer = writer;
+        trace.context = context;
+        trace.announced = 0;
+        trace.time = SMART_PTR_CLOCK();
+
+        // Write the magic bytes.
+        const uint8_t magic[4] = {'S', 'P', 'T', '1'};
+        allocation_trace::write(trace, magic, sizeof(magic));
+        allocation_trace::unlock(trace);
+    }
+#ifndef ARDUINO
+    /// \brief Starts recording into a file.
+    /// \param path The path of the file to create.
+    /// \return TRUE if the file was created, otherwise FALSE.
+    static bool start(const char* path)
+    {
+        FILE* file = fopen(path, "wb");
+        if(!file)
+        {
+            return false;
+        }
+        allocation_trace::start(&allocation_trace::write_file, file);
+
+        // Keep the file so that stop() closes it.
+        state& trace = allocation_trace::get_state();
+        allocation_trace::lock(trace);
+        trace.file = file;
+        allocation_trace::unlock(trace);
+        return true;
+    }
+#endif
+    /// \brief Stops recording, and closes the file opened by start(path).
+    static void stop()
+    {
+        state& trace = allocation_trace::get_state();
+        allocation_trace::lock(trace);
+        trace.writer = nullptr;
+#ifndef ARDUINO
+        if(trace.file)
+        {
+            fclose(trace.file);
+            trace.file = nullptr;
+        }
+#endif
+        allocation_trace::unlock(trace);
+    }
+
+    // RECORDS
+    /// \brief Records an allocation.
+    /// \param type The type of the allocation.
+    /// \param address The address of the allocation.
+    /// \param size The size of the allocation in bytes.
+    static void allocate(smart_ptr_type& type, const void* address, size_t size)
+    {
+        // Skip the writer's own allocations, which would otherwise lock the state again.
+        if(allocation_trace::writing())
+        {
+            return;
+        }
+
+        state& trace = allocation_trace::get_state();
+        allocation_trace::lock(trace);
+        if(trace.writer)
+        {
+            // Announce types registered since the last announcement.
+            if(type.index() >= trace.announced)
+            {
+                allocation_trace::announce(trace);
+            }
+
+            uint8_t record[1 + 4 * 10];
+            uint8_t* end = record;
+            *end++ = 'A';
+            end = allocation_trace::encode(end, allocation_trace::elapsed(trace));
+            end = allocation_trace::encode(end, reinterpret_cast<uintptr_t>(address));
+            end = allocation_trace::encode(end, size);
+            end = allocation_trace::encode(end, type.index());
+            allocation_trace::write(trace, record, end - record);
+        }
+        allocation_trace::unlock(trace);
+    }
+    /// \brief Records a free.
+    /// \param address The address of the allocation.
+    static void free(const void* address)
+    {
+        // Skip the writer's own frees, which would otherwise lock the state again.
+        if(allocation_trace::writing())
+        {
+            return;
+        }
+
+        state& trace = allocation_trace::get_state();
+        allocation_trace::lock(trace);
+        if(trace.writer)
+        {
+            uint8_t record[1 + 2 * 10];
+            uint8_t* end = record;
+            *end++ = 'F';
+            end = allocation_trace::encode(end, allocation_trace::elapsed(trace));
+            end = allocation_trace::encode(end, reinterpret_cast<uintptr_t>(address));
+            allocation_trace::write(trace, record, end - record);
+        }
+        allocation_trace::unlock(trace);
+    }
+
+private:
+    // STATE
+    /// \brief The state of the recorder.
+    struct state
+    {
+        /// \brief The writer, or nullptr if not recording.
+        writer_type writer;
+        /// \brief The context passed to the writer.
+        void* context;
+        /// \brief The number of types announced in the trace.
+        uint16_t announced;
+        /// \brief The time of the previous record.
+        uint32_t time;
+#ifndef ARDUINO
+        /// \brief The file opened by start(path), or nullptr.
+        FILE* file;
+        /// \brief Serializes records across threads.
+        std::mutex mutex;
+#endif
+    };
+    /// \brief Gets the state of the recorder.
+    /// \return A reference to the state.
+    static state& get_state()
+    {
+        static state trace = {};
+        return trace;
+    }
+    /// \brief Locks the state of the recorder. Does nothing on Arduino.
+    /// \param trace The state.
+    static void lock(state& trace)
+    {
+#ifndef ARDUINO
+        trace.mutex.lock();
+#endif
+    }
+    /// \brief Unlocks the state of the recorder. Does nothing on Arduino.
+    /// \param trace The state.
+    static void unlock(state& trace)
+    {
+#ifndef ARDUINO
+        trace.mutex.unlock();
+#endif
+    }
+
+    // WRITING
+    /// \brief Gets the flag that marks the calling thread as running the writer.
+    /// \return A reference to the flag.
+    static bool& writing()
+    {
+#ifndef ARDUINO
+        static thread_local bool active = false;
+#else
+        static bool active = false;
+#endif
+        return active;
+    }
+    /// \brief Passes trace data to the writer, marking the calling thread so that its allocations are not recorded.
+    /// \param trace The state.
+    /// \param data The data to write.
+    /// \param size The number of bytes to write.
+    static void write(state& trace, const uint8_t* data, size_t size)
+    {
+        allocation_trace::writing() = true;
+        trace.writer(data, size, trace.context);
+        allocation_trace::writing() = false;
+    }
+
+    // ENCODING
+    /// \brief Writes the type records of all types that have not been announced yet.
+    /// \param trace The state.
+    static void announce(state& trace)
+    {
+        uint16_t count = smart_ptr_type::count();
+        for(smart_ptr_type* type = smart_ptr_type::first(); type; type = type->next())
+        {
+            if(type->index() >= trace.announced)
+            {
+                uint8_t record[1 + 10 + 1];
+                uint8_t* end = record;
+                *end++ = 'T';
+                end = allocation_trace::encode(end, type->index());
+                *end++ = type->name_length();
+                allocation_trace::write(trace, record, end - record);
+                allocation_trace::write(trace, reinterpret_cast<const uint8_t*>(type->name()), type->name_length());
+            }
+        }
+        trace.announced = count;
+    }
+    /// \brief Gets the time since the previous record, and advances the time of the previous record.
+    /// \param trace The state.
+    /// \return The elapsed time in microseconds.
+    static uint32_t elapsed(state& trace)
+    {
+        uint32_t now = SMART_PTR_CLOCK();
+        uint32_t elapsed = now - trace.time;
+        trace.time = now;
+        return elapsed;
+    }
+    /// \brief Encodes an unsigned integer as a LEB128 varint.
+    /// \tparam value_type The unsigned type of the value, which avoids 64-bit arithmetic on small targets.
+    /// \param output The buffer to write to.
+    /// \param value The value to encode.
+    /// \return A pointer past the last byte written.
+    template <class value_type>
+    static uint8_t* encode(uint8_t* output, value_type value)
+    {
+        while(value >= 0x80)
+        {
+            *output++ = static_cast<uint8_t>(value) | 0x80;
+            value >>= 7;
+        }
+        *output++ = static_cast<uint8_t>(value);
+        return output;
+    }
+#ifndef ARDUINO
+    /// \brief Writes trace data to a file.
+    /// \param data The data to write.
+    /// \param size The number of bytes to write.
+    /// \param context The FILE to write to.
+    static void write_file(const uint8_t* data, size_t size, void* context)
+    {
+        fwrite(data, 1, size, static_cast<FILE*>(context));
+    }
+#endif
+};
+
+#endif
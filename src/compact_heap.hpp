@@ -0,0 +1,275 @@
+/// \file compact_heap.hpp
+/// \brief Defines the compact_heap class.
+#ifndef SMART_PTR___COMPACT_HEAP_H
+#define SMART_PTR___COMPACT_HEAP_H
+
+#include <smart_ptr_check.hpp>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/// \brief A heap that addresses its objects through handles, so it can slide live objects together to remove gaps.
+/// \details The heap owns one fixed buffer. Objects are allocated at the top of the buffer, and releasing an object
+/// leaves a gap that is reclaimed by defragment(), which slides unpinned objects down over the gaps and updates their
+/// handles. Compaction is incremental: each step moves at most a given number of bytes, so it can run in idle time.
+/// Objects are moved with memmove, so they must be trivially relocatable (for example, they must not hold pointers to
+/// themselves), and pointers into an object are only stable while the object is pinned.
+class compact_heap
+{
+public:
+    // TYPES
+    /// \brief The handle of an object.
+    typedef size_t handle_type;
+    /// \brief The handle that references no object.
+    static const handle_type null_handle = static_cast<handle_type>(-1);
+
+    // CONSTRUCTORS
+    /// \brief Creates a new compact_heap instance.
+    /// \param capacity The size of the heap's buffer in bytes.
+    /// \param handles The maximum number of objects that can be allocated at once.
+    compact_heap(size_t capacity, size_t handles)
+        : m_buffer(static_cast<uint8_t*>(::operator new(capacity))),
+          m_capacity(capacity),
+          m_top(0),
+          m_handles(new entry[handles]),
+          m_handle_count(handles),
+          m_scan(0),
+          m_destination(0)
+    {
+        // Mark all handles as free.
+        for(size_t i = 0; i < handles; ++i)
+        {
+            compact_heap::m_handles[i].object = nullptr;
+            compact_heap::m_handles[i].pins = 0;
+        }
+    }
+    compact_heap(const compact_heap& other) = delete;
+    compact_heap& operator=(const compact_heap& other) = delete;
+    /// \details All objects must be released before the heap is destroyed.
+    ~compact_heap()
+    {
+        delete[] compact_heap::m_handles;
+        ::operator delete(compact_heap::m_buffer);
+    }
+
+    // ALLOCATION
+    /// \brief Allocates storage for an object.
+    /// \details If there is not enough space at the top of the heap, the heap is fully defragmented first.
+    /// \param size The size of the object in bytes.
+    /// \return The handle of the storage, or null_handle if the heap or its handle table is full.
+    handle_type allocate(size_t size)
+    {
+        // Find a free handle.
+        handle_type handle = 0;
+        while(handle < compact_heap::m_handle_count && compact_heap::m_handles[handle].object)
+        {
+            ++handle;
+        }
+        if(handle == compact_heap::m_handle_count)
+        {
+            return compact_heap::null_handle;
+        }
+
+        // Make room at the top of the heap.
+        size_t block_size = compact_heap::round(sizeof(block) + size);
+        if(compact_heap::m_capacity - compact_heap::m_top < block_size)
+        {
+            compact_heap::defragment();
+            if(compact_heap::m_capacity - compact_heap::m_top < block_size)
+            {
+                return compact_heap::null_handle;
+            }
+        }
+
+        // Bump allocate the block.
+        block* allocated = reinterpret_cast<block*>(compact_heap::m_buffer + compact_heap::m_top);
+        allocated->size = block_size;
+        allocated->handle = handle;
+        compact_heap::m_top += block_size;
+        compact_heap::m_handles[handle].object = allocated + 1;
+
+        return handle;
+    }
+    /// \brief Releases the storage of an object. The object must already be destroyed and unpinned.
+    /// \param handle The handle of the storage.
+    void release(handle_type handle)
+    {
+        SMART_PTR_CHECK(compact_heap::m_handles[handle].pins == 0);
+
+        // Mark the block as a gap and free the handle.
+        block* released = static_cast<block*>(compact_heap::m_handles[handle].object) - 1;
+        released->handle = compact_heap::null_handle;
+        compact_heap::m_handles[handle].object = nullptr;
+    }
+
+    // ACCESS
+    /// \brief Gets the current address of an object.
+    /// \details The address is only stable while the object is pinned.
+    /// \param handle The handle of the object.
+    /// \return A pointer to the object.
+    void* object(handle_type handle) const
+    {
+        return compact_heap::m_handles[handle].object;
+    }
+    /// \brief Pins an object, preventing defragment() from moving it.
+    /// \param handle The handle of the object.
+    void pin(handle_type handle)
+    {
+        SMART_PTR_CHECK(compact_heap::m_handles[handle].pins != SIZE_MAX);
+        ++compact_heap::m_handles[handle].pins;
+    }
+    /// \brief Unpins an object pinned by pin().
+    /// \param handle The handle of the object.
+    void unpin(handle_type handle)
+    {
+        SMART_PTR_CHECK(compact_heap::m_handles[handle].pins != 0);
+        --compact_heap::m_handles[handle].pins;
+    }
+
+    // DEFRAGMENTATION
+    /// \brief Performs one step of compaction.
+    /// \details Slides unpinned objects down over gaps until about budget bytes have been moved. Pinned objects stay
+    /// in place, and the gaps below them are reclaimed by a later pass after they are unpinned.
+    /// \param budget The maximum number of bytes to move in this step. Bounds the time spent in the step. A step
+    /// always moves at least one object, so that objects larger than the budget are not skipped forever.
+    /// \return TRUE if the pass finished and the heap is compact, FALSE if more steps are needed.
+    bool defragment(size_t budget)
+    {
+        size_t moved = 0;
+        while(compact_heap::m_scan < compact_heap::m_top)
+        {
+            block* current = reinterpret_cast<block*>(compact_heap::m_buffer + compact_heap::m_scan);
+            size_t size = current->size;
+
+            if(current->handle == compact_heap::null_handle)
+            {
+                // Absorb the gap.
+                compact_heap::m_scan += size;
+            }
+            else if(compact_heap::m_handles[current->handle].pins || compact_heap::m_destination == compact_heap::m_scan)
+            {
+                // Leave pinned and already compact blocks in place, closing the gap below them.
+                compact_heap::mark_gap();
+                compact_heap::m_scan += size;
+                compact_heap::m_destination = compact_heap::m_scan;
+            }
+            else
+            {
+                // Stop if the budget does not cover the block.
+                if(moved != 0 && moved + size > budget)
+                {
+                    compact_heap::mark_gap();
+                    return false;
+                }
+                moved += size;
+
+                // Slide the block down and update its handle.
+                block* destination = reinterpret_cast<block*>(compact_heap::m_buffer + compact_heap::m_destination);
+                memmove(destination, current, size);
+                compact_heap::m_handles[destination->handle].object = destination + 1;
+                compact_heap::m_destination += size;
+                compact_heap::m_scan += size;
+            }
+        }
+
+        // Lower the top over the trailing gap and restart the pass.
+        compact_heap::m_top = compact_heap::m_destination;
+        compact_heap::m_scan = 0;
+        compact_heap::m_destination = 0;
+        return true;
+    }
+    /// \brief Compacts the heap completely, apart from gaps below pinned objects.
+    void defragment()
+    {
+        // Finish any pass in progress, then run one full pass.
+        if(compact_heap::m_scan != 0)
+        {
+            compact_heap::defragment(compact_heap::m_capacity);
+        }
+        compact_heap::defragment(compact_heap::m_capacity);
+    }
+
+    // STATISTICS
+    /// \brief Gets the number of bytes available at the top of the heap without defragmenting.
+    /// \return The number of bytes.
+    size_t available() const
+    {
+        return compact_heap::m_capacity - compact_heap::m_top;
+    }
+    /// \brief Gets the number of bytes used by live objects and their headers.
+    /// \return The number of bytes.
+    size_t used() const
+    {
+        size_t total = 0;
+        for(size_t offset = 0; offset < compact_heap::m_top;)
+        {
+            const block* current = reinterpret_cast<const block*>(compact_heap::m_buffer + offset);
+            if(current->handle != compact_heap::null_handle)
+            {
+                total += current->size;
+            }
+            offset += current->size;
+        }
+        return total;
+    }
+
+private:
+    // TYPES
+    /// \brief The header of a block in the buffer, directly followed by the object.
+    struct block
+    {
+        /// \brief The size of the block in bytes, including this header.
+        size_t size;
+        /// \brief The handle of the object, or null_handle if the block is a gap.
+        handle_type handle;
+    };
+    /// \brief An entry of the handle table.
+    struct entry
+    {
+        /// \brief The current address of the object, or nullptr if the handle is free.
+        void* object;
+        /// \brief The number of active pins of the object. As wide as a size_t, so nested pins cannot wrap it to zero.
+        size_t pins;
+    };
+
+    // STORAGE
+    /// \brief The buffer holding the blocks.
+    uint8_t* m_buffer;
+    /// \brief The size of the buffer in bytes.
+    size_t m_capacity;
+    /// \brief The offset of the end of the last block.
+    size_t m_top;
+
+    // HANDLES
+    /// \brief The handle table.
+    entry* m_handles;
+    /// \brief The number of entries in the handle table.
+    size_t m_handle_count;
+
+    // COMPACTION
+    /// \brief The offset of the next block to examine in the current pass.
+    size_t m_scan;
+    /// \brief The offset where the next moved block is placed. Everything below it is compact.
+    size_t m_destination;
+
+    /// \brief Writes a gap header over the space between the compacted blocks and the next block to examine.
+    void mark_gap()
+    {
+        if(compact_heap::m_scan != compact_heap::m_destination)
+        {
+            block* gap = reinterpret_cast<block*>(compact_heap::m_buffer + compact_heap::m_destination);
+            gap->size = compact_heap::m_scan - compact_heap::m_destination;
+            gap->handle = compact_heap::null_handle;
+        }
+    }
+    /// \brief Rounds a block size up to the alignment of block headers.
+    /// \param size The size in bytes.
+    /// \return The rounded size.
+    static size_t round(size_t size)
+    {
+        return (size + alignof(block) - 1) / alignof(block) * alignof(block);
+    }
+};
+
+#endif
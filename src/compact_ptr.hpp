@@ -0,0 +1,221 @@
+/// \file compact_ptr.hpp
+/// \brief Defines the compact_ptr class.
+#ifndef SMART_PTR___COMPACT_PTR_H
+#define SMART_PTR___COMPACT_PTR_H
+
+#include <compact_heap.hpp>
+#include <smart_ptr_check.hpp>
+
+#include <new>
+
+/// \brief Pins an object of a compact_heap in place for as long as the compact_pin exists.
+/// \details Dereferencing a compact_ptr returns a temporary compact_pin, so the object cannot be moved by
+/// defragment() while a member function called through the compact_ptr is running.
+/// \tparam object_type The type of the object.
+template <class object_type>
+class compact_pin
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Creates a new compact_pin instance that pins an object.
+    /// \param heap The heap holding the object, which must not be nullptr.
+    /// \param handle The handle of the object, which must not be null_handle.
+    compact_pin(compact_heap* heap, compact_heap::handle_type handle)
+        : m_heap(heap),
+          m_handle(handle)
+    {
+        SMART_PTR_CHECK(heap && handle != compact_heap::null_handle);
+
+        // Pin the object.
+        compact_pin::m_heap->pin(compact_pin::m_handle);
+    }
+    /// \brief Copy constructs from another compact pin instance, adding another pin.
+    /// \param other The compact_pin instance to copy.
+    compact_pin(const compact_pin<object_type>& other)
+        : compact_pin(other.m_heap, other.m_handle)
+    {}
+    compact_pin<object_type>& operator=(const compact_pin<object_type>& other) = delete;
+    ~compact_pin()
+    {
+        // Unpin the object.
+        compact_pin::m_heap->unpin(compact_pin::m_handle);
+    }
+
+    // ACCESS
+    /// \brief Gets the pointer to the pinned object instance.
+    /// \return A pointer to the object instance, which is stable for the lifetime of this compact_pin.
+    object_type* get() const
+    {
+        return static_cast<object_type*>(compact_pin::m_heap->object(compact_pin::m_handle));
+    }
+    /// \brief Dereferences the pointer to the pinned object instance.
+    /// \return A pointer to the object instance.
+    object_type* operator->() const
+    {
+        return compact_pin::get();
+    }
+    /// \brief Dereferences the pointer to the pinned object instance.
+    /// \return A reference to the object instance.
+    object_type& operator*() const
+    {
+        return *compact_pin::get();
+    }
+
+private:
+    // OBJECT
+    /// \brief The heap holding the object.
+    compact_heap* m_heap;
+    /// \brief The handle of the object.
+    compact_heap::handle_type m_handle;
+};
+
+/// \brief A smart pointer that retains unique ownership of an object in a compact_heap through a handle.
+/// \details The extra indirection through the handle table lets the heap move the object to defeat fragmentation.
+/// The object is pinned while it is dereferenced through operator->() or pin(); there is no operator*(), since a
+/// reference would not keep the object pinned.
+/// \tparam object_type The type of the object. Must be trivially relocatable.
+template <class object_type>
+class compact_ptr
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Creates a new, empty compact_ptr instance.
+    compact_ptr()
+        : m_heap(nullptr),
+          m_handle(compact_heap::null_handle)
+    {}
+    /// \brief Creates a new compact_ptr instance that takes ownership of a constructed object in a heap.
+    /// \param heap The heap holding the object.
+    /// \param handle The handle of the object.
+    compact_ptr(compact_heap* heap, compact_heap::handle_type handle)
+        : m_heap(heap),
+          m_handle(handle)
+    {}
+    /// \brief Move constructs from another compact pointer instance.
+    /// \param other The compact_ptr instance to move.
+    compact_ptr(compact_ptr<object_type>&& other)
+        : m_heap(other.m_heap),
+          m_handle(other.m_handle)
+    {
+        // Clear other's handle.
+        other.m_handle = compact_heap::null_handle;
+    }
+    compact_ptr(const compact_ptr<object_type>& other) = delete;
+    ~compact_ptr()
+    {
+        // Destroy the object instance.
+        compact_ptr::destroy();
+    }
+
+    // RESET
+    /// \brief Resets the compact_ptr to nullptr.
+    void reset()
+    {
+        // Destroy and reset the object instance.
+        compact_ptr::destroy();
+        compact_ptr::m_handle = compact_heap::null_handle;
+    }
+
+    // ASSIGNMENT
+    /// \brief Move assigns this compact_ptr from another compact_ptr.
+    /// \param other The compact_ptr instance to move.
+    /// \return A reference to this compact_ptr.
+    compact_ptr<object_type>& operator=(compact_ptr<object_type>&& other)
+    {
+        // Destroy old instance.
+        compact_ptr::destroy();
+
+        // Store new instance.
+        compact_ptr::m_heap = other.m_heap;
+        compact_ptr::m_handle = other.m_handle;
+
+        // Remove instance from other object.
+        other.m_handle = compact_heap::null_handle;
+
+        return *this;
+    }
+    compact_ptr<object_type>& operator=(const compact_ptr<object_type>& other) = delete;
+
+    // ACCESS
+    /// \brief Pins the managed object instance so that it can be accessed through a stable pointer.
+    /// \details The compact_ptr must not be empty.
+    /// \return A compact_pin that keeps the object in place while it exists.
+    compact_pin<object_type> pin() const
+    {
+        SMART_PTR_CHECK(compact_ptr::m_handle != compact_heap::null_handle);
+        return compact_pin<object_type>(compact_ptr::m_heap, compact_ptr::m_handle);
+    }
+    /// \brief Dereferences the managed object instance, pinning it until the end of the full expression.
+    /// \return A temporary compact_pin of the object instance.
+    compact_pin<object_type> operator->() const
+    {
+        SMART_PTR_CHECK(compact_ptr::m_handle != compact_heap::null_handle);
+        return compact_ptr::pin();
+    }
+    /// \brief Gets the current address of the managed object instance without pinning it.
+    /// \details The address is invalidated by the next defragment() or allocation in the heap.
+    /// \return A pointer to the object instance, or nullptr if the compact_ptr is empty.
+    object_type* get() const
+    {
+        if(compact_ptr::m_handle == compact_heap::null_handle)
+        {
+            return nullptr;
+        }
+        return static_cast<object_type*>(compact_ptr::m_heap->object(compact_ptr::m_handle));
+    }
+    /// \brief Checks if this compact_ptr references an object instance.
+    /// \return TRUE if this compact_ptr references an object instance, false if it is nullptr.
+    operator bool() const
+    {
+        return compact_ptr::m_handle != compact_heap::null_handle;
+    }
+
+private:
+    // OBJECT
+    /// \brief The heap holding the object.
+    compact_heap* m_heap;
+    /// \brief The handle of the object, or null_handle if this compact_ptr is empty.
+    compact_heap::handle_type m_handle;
+
+    // DESTRUCTION
+    /// \brief Destroys the managed object instance and releases its storage.
+    void destroy()
+    {
+        if(compact_ptr::m_handle != compact_heap::null_handle)
+        {
+            // Destroy the object pinned, in case its destructor allocates from the heap.
+            compact_ptr::m_heap->pin(compact_ptr::m_handle);
+            compact_ptr::get()->~object_type();
+            compact_ptr::m_heap->unpin(compact_ptr::m_handle);
+            compact_ptr::m_heap->release(compact_ptr::m_handle);
+        }
+    }
+};
+
+// UTILITIES
+/// \brief Creates a compact_ptr managing a new instance of an object in a compact_heap.
+/// \tparam object_type The type of the object. Must be trivially relocatable.
+/// \tparam args The variadic types of the object's constructor parameters.
+/// \param heap The heap to allocate the object in.
+/// \param arguments The arguments to pass to the object's constructor.
+/// \return A compact_ptr managing the new instance of the object, or an empty compact_ptr if the heap is full.
+template <class object_type, class... args>
+compact_ptr<object_type> make_compact(compact_heap& heap, args&&... arguments)
+{
+    static_assert(alignof(object_type) <= alignof(size_t), "Objects in a compact_heap are only aligned to size_t.");
+
+    // Allocate storage for the object.
+    compact_heap::handle_type handle = heap.allocate(sizeof(object_type));
+    if(handle == compact_heap::null_handle)
+    {
+        return compact_ptr<object_type>();
+    }
+
+    // Construct the object in place, pinned in case its constructor allocates from the heap.
+    heap.pin(handle);
+    new (heap.object(handle)) object_type(arguments...);
+    heap.unpin(handle);
+    return compact_ptr<object_type>(&heap, handle);
+}
+
+#endif
@@ -0,0 +1,35 @@
+/// \file default_delete.hpp
+/// \brief Defines the default_delete class.
+#ifndef SMART_PTR___DEFAULT_DELETE_H
+#define SMART_PTR___DEFAULT_DELETE_H
+
+/// \brief The default deleter of a unique_ptr, which deletes the object with delete.
+/// \tparam object_type The type of the object.
+template <class object_type>
+struct default_delete
+{
+    /// \brief Deletes an object instance.
+    /// \param object The object instance to delete.
+    void operator()(object_type* object) const
+    {
+        delete object;
+    }
+};
+
+/// \brief The default deleter of a unique_ptr to an array, which deletes the array with delete[].
+/// \tparam object_type The type of the array's elements.
+template <class object_type>
+struct default_delete<object_type[]>
+{
+    /// \brief Deletes an array of object instances.
+    /// \param objects The array to delete.
+    void operator()(object_type* objects) const
+    {
+        delete[] objects;
+    }
+};
+
+template <class object_type, class deleter_type = default_delete<object_type>>
+class unique_ptr;
+
+#endif
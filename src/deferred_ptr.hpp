@@ -0,0 +1,498 @@
+/// \file deferred_ptr.hpp
+/// \brief Defines the deferred_ptr and local_ptr classes and their deferred reference counting heap.
+#ifndef SMART_PTR___DEFERRED_PTR_H
+#define SMART_PTR___DEFERRED_PTR_H
+
+#include <smart_ptr_check.hpp>
+
+#include <stddef.h>
+
+class deferred_heap;
+class deferred_root;
+template <class object_type>
+class deferred_ptr;
+
+/// \brief The reference count header of an object managed by deferred reference counting.
+class deferred_object
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Creates a new deferred_object instance.
+    /// \param destroy The function that destroys the object and frees its memory.
+    deferred_object(void (*destroy)(deferred_object* object))
+        : m_destroy(destroy),
+          m_count(0),
+          m_next(nullptr),
+          m_in_table(false),
+          m_marked(false)
+    {}
+    deferred_object(const deferred_object& other) = delete;
+    deferred_object& operator=(const deferred_object& other) = delete;
+
+private:
+    // HEADER
+    /// \brief Destroys the object and frees its memory.
+    void (*m_destroy)(deferred_object* object);
+    /// \brief The number of deferred_ptrs referencing the object. References from local_ptrs are not counted.
+    size_t m_count;
+    /// \brief The next object in the zero count table.
+    deferred_object* m_next;
+    /// \brief Indicates if the object is in the zero count table.
+    bool m_in_table;
+    /// \brief Indicates if a local_ptr references the object during reconciliation.
+    bool m_marked;
+
+    friend class deferred_heap;
+};
+
+/// \brief The allocation holding an object managed by deferred reference counting.
+/// \tparam object_type The type of the object.
+template <class object_type>
+class deferred_block
+    : public deferred_object
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Creates a new deferred_block instance.
+    /// \tparam args The variadic types of the object's constructor parameters.
+    /// \param arguments The arguments to pass to the object's constructor.
+    template <class... args>
+    deferred_block(args&&... arguments)
+        : deferred_object(&deferred_block::destroy_block),
+          object(arguments...)
+    {}
+
+    /// \brief The object.
+    object_type object;
+
+private:
+    // DESTRUCTION
+    /// \brief Destroys a deferred_block<object_type>.
+    /// \param block The block to destroy.
+    static void destroy_block(deferred_object* block)
+    {
+        delete static_cast<deferred_block*>(block);
+    }
+};
+
+/// \brief A scoped handle that keeps an object alive without being counted.
+/// \details Roots form a stack, and must be destroyed in the reverse order of their creation, as automatic variables
+/// are.
+class deferred_root
+{
+public:
+    // CONSTRUCTORS
+    deferred_root(deferred_root&& other) = delete;
+    deferred_root& operator=(const deferred_root& other) = delete;
+
+protected:
+    // CONSTRUCTORS
+    /// \brief Creates a new deferred_root instance and pushes it onto the root stack.
+    /// \param target The object to keep alive, or nullptr.
+    explicit deferred_root(deferred_object* target);
+    ~deferred_root();
+
+    // TARGET
+    /// \brief The object kept alive by this root, or nullptr.
+    deferred_object* m_target;
+
+private:
+    // STACK
+    /// \brief The root created before this one.
+    deferred_root* m_next;
+
+    friend class deferred_heap;
+};
+
+/// \brief The zero count table and root stack shared by all objects managed by deferred reference counting.
+/// \details This is deferred reference counting in the style of Deutsch and Bobrow: only references stored in
+/// deferred_ptrs are counted, while local_ptrs in automatic variables register as roots without touching counts.
+/// An object whose count drops to zero may still be referenced by a local_ptr, so instead of being destroyed it is
+/// added to the zero count table. reconcile() destroys every object in the table that is neither counted nor
+/// referenced by a root, and must be called at safe points where no object is referenced only through a raw
+/// pointer. The heap is not thread safe; use it from a single thread.
+class deferred_heap
+{
+public:
+    // RECONCILIATION
+    /// \brief Destroys the objects in the zero count table that no deferred_ptr or local_ptr references.
+    /// \return The number of objects destroyed.
+    static size_t reconcile()
+    {
+        state& heap = deferred_heap::get_state();
+
+        // Mark the objects referenced by roots.
+        for(deferred_root* root = heap.roots; root; root = root->m_next)
+        {
+            if(root->m_target)
+            {
+                root->m_target->m_marked = true;
+            }
+        }
+
+        // Process the table until destroying objects adds no more entries.
+        size_t destroyed = 0;
+        deferred_object* kept = nullptr;
+        size_t kept_size = 0;
+        while(heap.table)
+        {
+            deferred_object* entry = heap.table;
+            heap.table = nullptr;
+            heap.table_size = 0;
+            while(entry)
+            {
+                deferred_object* current = entry;
+                entry = current->m_next;
+                if(current->m_count)
+                {
+                    // Counted again since it was added.
+                    current->m_in_table = false;
+                }
+                else if(current->m_marked)
+                {
+                    // Referenced only by roots, so check it again at the next safe point.
+                    current->m_next = kept;
+                    kept = current;
+                    ++kept_size;
+                }
+                else
+                {
+                    current->m_destroy(current);
+                    ++destroyed;
+                }
+            }
+        }
+        heap.table = kept;
+        heap.table_size = kept_size;
+
+        // Clear the marks.
+        for(deferred_root* root = heap.roots; root; root = root->m_next)
+        {
+            if(root->m_target)
+            {
+                root->m_target->m_marked = false;
+            }
+        }
+
+        return destroyed;
+    }
+    /// \brief Gets the number of objects waiting in the zero count table.
+    /// \return The number of objects.
+    static size_t pending()
+    {
+        return deferred_heap::get_state().table_size;
+    }
+
+private:
+    // STATE
+    /// \brief The state of the heap.
+    struct state
+    {
+        /// \brief The zero count table.
+        deferred_object* table;
+        /// \brief The number of objects in the zero count table.
+        size_t table_size;
+        /// \brief The most recently created root.
+        deferred_root* roots;
+    };
+    /// \brief Gets the state of the heap.
+    /// \return A reference to the state.
+    static state& get_state()
+    {
+        static state heap = {nullptr, 0, nullptr};
+        return heap;
+    }
+
+    // COUNTS
+    /// \brief Increments the count of an object.
+    /// \param object The object, or nullptr.
+    static void increment(deferred_object* object)
+    {
+        if(object)
+        {
+            ++object->m_count;
+        }
+    }
+    /// \brief Decrements the count of an object, adding it to the zero count table if the count reaches zero.
+    /// \param object The object, or nullptr.
+    static void decrement(deferred_object* object)
+    {
+        if(object)
+        {
+            SMART_PTR_CHECK(object->m_count != 0);
+            if(--object->m_count == 0 && !object->m_in_table)
+            {
+                deferred_heap::add(object);
+            }
+        }
+    }
+    /// \brief Adds an object to the zero count table.
+    /// \param object The object.
+    static void add(deferred_object* object)
+    {
+        state& heap = deferred_heap::get_state();
+        object->m_in_table = true;
+        object->m_next = heap.table;
+        heap.table = object;
+        ++heap.table_size;
+    }
+
+    // ROOTS
+    /// \brief Pushes a root onto the root stack.
+    /// \param root The root.
+    static void push(deferred_root* root)
+    {
+        state& heap = deferred_heap::get_state();
+        root->m_next = heap.roots;
+        heap.roots = root;
+    }
+    /// \brief Pops a root off the root stack.
+    /// \param root The root, which must be the most recently created root.
+    static void pop(deferred_root* root)
+    {
+        state& heap = deferred_heap::get_state();
+        SMART_PTR_CHECK(heap.roots == root);
+        heap.roots = root->m_next;
+    }
+
+    friend class deferred_root;
+    template <class object_type>
+    friend class deferred_ptr;
+};
+
+inline deferred_root::deferred_root(deferred_object* target)
+    : m_target(target)
+{
+    deferred_heap::push(this);
+}
+inline deferred_root::~deferred_root()
+{
+    deferred_heap::pop(this);
+}
+
+/// \brief A counted reference to an object managed by deferred reference counting.
+/// \details Use deferred_ptr for references stored in objects, containers and globals, and local_ptr for references
+/// held in automatic variables. When the last deferred_ptr is released, the object waits in the zero count table
+/// until deferred_heap::reconcile() finds that no local_ptr references it.
+/// \tparam object_type The type of the object.
+template <class object_type>
+class deferred_ptr
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Creates a new, empty deferred_ptr instance.
+    deferred_ptr()
+        : m_block(nullptr)
+    {}
+    /// \brief Creates a new deferred_ptr instance referencing a block.
+    /// \param block The block to reference, or nullptr.
+    explicit deferred_ptr(deferred_block<object_type>* block)
+        : m_block(block)
+    {
+        deferred_heap::increment(block);
+    }
+    /// \brief Copy constructs from another deferred_ptr instance.
+    /// \param other The deferred_ptr instance to copy.
+    deferred_ptr(const deferred_ptr<object_type>& other)
+        : m_block(other.m_block)
+    {
+        deferred_heap::increment(deferred_ptr::m_block);
+    }
+    /// \brief Move constructs from another deferred_ptr instance.
+    /// \param other The deferred_ptr instance to move.
+    deferred_ptr(deferred_ptr<object_type>&& other)
+        : m_block(other.m_block)
+    {
+        // NOTE: the count remains the same due to move.
+        other.m_block = nullptr;
+    }
+    ~deferred_ptr()
+    {
+        deferred_heap::decrement(deferred_ptr::m_block);
+    }
+
+    // RESET
+    /// \brief Resets the deferred_ptr to nullptr.
+    void reset()
+    {
+        deferred_heap::decrement(deferred_ptr::m_block);
+        deferred_ptr::m_block = nullptr;
+    }
+
+    // ASSIGNMENT
+    /// \brief Copy assigns this deferred_ptr from another deferred_ptr.
+    /// \param other The deferred_ptr instance to copy.
+    /// \return A reference to this deferred_ptr.
+    deferred_ptr<object_type>& operator=(const deferred_ptr<object_type>& other)
+    {
+        // Increment the new count first, in case both reference the same object.
+        deferred_heap::increment(other.m_block);
+        deferred_heap::decrement(deferred_ptr::m_block);
+        deferred_ptr::m_block = other.m_block;
+        return *this;
+    }
+    /// \brief Move assigns this deferred_ptr from another deferred_ptr.
+    /// \param other The deferred_ptr instance to move.
+    /// \return A reference to this deferred_ptr.
+    deferred_ptr<object_type>& operator=(deferred_ptr<object_type>&& other)
+    {
+        if(this != &other)
+        {
+            deferred_heap::decrement(deferred_ptr::m_block);
+            deferred_ptr::m_block = other.m_block;
+            other.m_block = nullptr;
+        }
+        return *this;
+    }
+
+    // ACCESS
+    /// \brief Gets the pointer to the referenced object instance.
+    /// \return A pointer to the object instance.
+    object_type* get() const
+    {
+        return deferred_ptr::m_block ? &deferred_ptr::m_block->object : nullptr;
+    }
+    /// \brief Dereferences the pointer to the referenced object instance.
+    /// \return A pointer to the object instance.
+    object_type* operator->() const
+    {
+        SMART_PTR_CHECK(deferred_ptr::m_block);
+        return &deferred_ptr::m_block->object;
+    }
+    /// \brief Dereferences the pointer to the referenced object instance.
+    /// \return A reference to the object instance.
+    object_type& operator*() const
+    {
+        SMART_PTR_CHECK(deferred_ptr::m_block);
+        return deferred_ptr::m_block->object;
+    }
+    /// \brief Checks if this deferred_ptr references an object instance.
+    /// \return TRUE if this deferred_ptr references an object instance, false if it is nullptr.
+    operator bool() const
+    {
+        return deferred_ptr::m_block != nullptr;
+    }
+    /// \brief Gets the block holding the referenced object.
+    /// \return A pointer to the block, or nullptr.
+    deferred_block<object_type>* block() const
+    {
+        return deferred_ptr::m_block;
+    }
+
+private:
+    // OBJECT
+    /// \brief The block holding the referenced object.
+    deferred_block<object_type>* m_block;
+};
+
+/// \brief An uncounted reference to an object managed by deferred reference counting, for automatic variables.
+/// \details Creating, copying, assigning and destroying a local_ptr never touches the object's count; the object is
+/// kept alive because deferred_heap::reconcile() scans every live local_ptr. local_ptrs must be destroyed in the
+/// reverse order of their creation, so they can only be automatic variables; return a deferred_ptr from functions
+/// instead. When SMART_PTR_CHECKED is defined, destroying a local_ptr out of order traps.
+/// \tparam object_type The type of the object.
+template <class object_type>
+class local_ptr
+    : private deferred_root
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Creates a new, empty local_ptr instance.
+    local_ptr()
+        : deferred_root(nullptr)
+    {}
+    /// \brief Copy constructs from another local_ptr instance.
+    /// \param other The local_ptr instance to copy.
+    local_ptr(const local_ptr<object_type>& other)
+        : deferred_root(other.m_target)
+    {}
+    /// \brief Creates a new local_ptr instance from a deferred_ptr.
+    /// \param pointer The deferred_ptr referencing the object.
+    local_ptr(const deferred_ptr<object_type>& pointer)
+        : deferred_root(pointer.block())
+    {}
+
+    // RESET
+    /// \brief Resets the local_ptr to nullptr.
+    void reset()
+    {
+        deferred_root::m_target = nullptr;
+    }
+
+    // ASSIGNMENT
+    /// \brief Copy assigns this local_ptr from another local_ptr.
+    /// \param other The local_ptr instance to copy.
+    /// \return A reference to this local_ptr.
+    local_ptr<object_type>& operator=(const local_ptr<object_type>& other)
+    {
+        deferred_root::m_target = other.m_target;
+        return *this;
+    }
+    /// \brief Assigns this local_ptr from a deferred_ptr.
+    /// \param pointer The deferred_ptr referencing the object.
+    /// \return A reference to this local_ptr.
+    local_ptr<object_type>& operator=(const deferred_ptr<object_type>& pointer)
+    {
+        deferred_root::m_target = pointer.block();
+        return *this;
+    }
+
+    // CONVERSION
+    /// \brief Creates a counted deferred_ptr referencing the same object, for storing outside automatic variables.
+    /// \return A deferred_ptr referencing the object.
+    operator deferred_ptr<object_type>() const
+    {
+        return deferred_ptr<object_type>(local_ptr::block());
+    }
+
+    // ACCESS
+    /// \brief Gets the pointer to the referenced object instance.
+    /// \return A pointer to the object instance.
+    object_type* get() const
+    {
+        return deferred_root::m_target ? &local_ptr::block()->object : nullptr;
+    }
+    /// \brief Dereferences the pointer to the referenced object instance.
+    /// \return A pointer to the object instance.
+    object_type* operator->() const
+    {
+        SMART_PTR_CHECK(deferred_root::m_target);
+        return &local_ptr::block()->object;
+    }
+    /// \brief Dereferences the pointer to the referenced object instance.
+    /// \return A reference to the object instance.
+    object_type& operator*() const
+    {
+        SMART_PTR_CHECK(deferred_root::m_target);
+        return local_ptr::block()->object;
+    }
+    /// \brief Checks if this local_ptr references an object instance.
+    /// \return TRUE if this local_ptr references an object instance, false if it is nullptr.
+    operator bool() const
+    {
+        return deferred_root::m_target != nullptr;
+    }
+
+private:
+    // OBJECT
+    /// \brief Gets the block holding the referenced object.
+    /// \return A pointer to the block, or nullptr.
+    deferred_block<object_type>* block() const
+    {
+        return static_cast<deferred_block<object_type>*>(deferred_root::m_target);
+    }
+};
+
+// UTILITIES
+/// \brief Creates a deferred_ptr referencing a new instance of an object.
+/// \tparam object_type The type of the object.
+/// \tparam args The variadic types of the object's constructor parameters.
+/// \param arguments The arguments to pass to the object's constructor.
+/// \return A deferred_ptr referencing the new instance of the object.
+template <class object_type, class... args>
+deferred_ptr<object_type> make_deferred(args&&... arguments)
+{
+    return deferred_ptr<object_type>(new deferred_block<object_type>(arguments...));
+}
+
+#endif
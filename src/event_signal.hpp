@@ -0,0 +1,207 @@
+/// \file event_signal.hpp
+/// \brief Defines the event_signal class.
+#ifndef SMART_PTR___EVENT_SIGNAL_H
+#define SMART_PTR___EVENT_SIGNAL_H
+
+#include <shared_ptr.hpp>
+
+#include <stdint.h>
+
+/// \brief Dispatches events to member functions of listeners owned by shared_ptrs.
+/// \details Slots hold weak references to their listeners, so a listener that has been destroyed is skipped when
+/// the signal is emitted and its slot is pruned. Slots are stored in one contiguous array.
+/// A listener must not destroy itself from within its own slot.
+/// \tparam args The types of the event's arguments.
+template <class... args>
+class event_signal
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Creates a new event_signal instance with no slots.
+    event_signal()
+        : m_slots(nullptr),
+          m_size(0),
+          m_capacity(0),
+          m_emitting(0),
+          m_dead(false)
+    {}
+    event_signal(const event_signal<args...>& other) = delete;
+    event_signal<args...>& operator=(const event_signal<args...>& other) = delete;
+    ~event_signal()
+    {
+        // Release the weak references of all slots.
+        for(size_t i = 0; i < event_signal::m_size; ++i)
+        {
+            if(event_signal::m_slots[i].count)
+            {
+                event_signal::m_slots[i].count->decrement_weak_count();
+            }
+        }
+        delete[] event_signal::m_slots;
+    }
+
+    // CONNECTION
+    /// \brief Connects a member function of a listener to this signal.
+    /// \tparam listener_type The type of the listener.
+    /// \tparam method The member function to call when the signal is emitted.
+    /// \param listener The shared_ptr managing the listener.
+    template <class listener_type, void (listener_type::*method)(args...)>
+    void connect(const shared_ptr<listener_type>& listener)
+    {
+        // Ignore empty listeners.
+        if(!listener.m_count)
+        {
+            return;
+        }
+
+        // Grow the slot array if full.
+        if(event_signal::m_size == event_signal::m_capacity)
+        {
+            event_signal::reserve(event_signal::m_capacity ? event_signal::m_capacity * 2 : 4);
+        }
+
+        // Store a weak reference to the listener.
+        listener.m_count->increment_weak_count();
+        slot& added = event_signal::m_slots[event_signal::m_size++];
+        added.count = listener.m_count;
+        added.listener = listener.m_object;
+        added.invoke = &event_signal::template invoke<listener_type, method>;
+    }
+    /// \brief Disconnects all slots of a listener from this signal.
+    /// \tparam listener_type The type of the listener.
+    /// \param listener The shared_ptr managing the listener.
+    template <class listener_type>
+    void disconnect(const shared_ptr<listener_type>& listener)
+    {
+        for(size_t i = 0; i < event_signal::m_size; ++i)
+        {
+            slot& current = event_signal::m_slots[i];
+            if(current.count && current.count == listener.m_count)
+            {
+                // Mark the slot as dead so that it is pruned.
+                current.count->decrement_weak_count();
+                current.count = nullptr;
+                event_signal::m_dead = true;
+            }
+        }
+
+        // Prune now unless an emission is iterating over the slots.
+        if(!event_signal::m_emitting)
+        {
+            event_signal::prune();
+        }
+    }
+    /// \brief Gets the number of connected slots, including slots of listeners that have not been pruned yet.
+    /// \return The number of slots.
+    size_t size() const
+    {
+        return event_signal::m_size;
+    }
+
+    // EMISSION
+    /// \brief Calls every slot whose listener still exists.
+    /// \param arguments The event's arguments.
+    void emit(args... arguments)
+    {
+        ++event_signal::m_emitting;
+
+        // Iterate by index, since slots may connect to this signal and grow the array.
+        for(size_t i = 0; i < event_signal::m_size; ++i)
+        {
+            const slot& current = event_signal::m_slots[i];
+            if(current.count && current.count->use_count() != 0)
+            {
+                current.invoke(current.listener, arguments...);
+            }
+            else
+            {
+                event_signal::m_dead = true;
+            }
+        }
+
+        // Prune dead slots once the outermost emission finishes.
+        if(--event_signal::m_emitting == 0)
+        {
+            event_signal::prune();
+        }
+    }
+
+private:
+    // TYPES
+    /// \brief A connected member function of a listener.
+    struct slot
+    {
+        /// \brief The reference counts of the listener, or nullptr if the slot was disconnected.
+        shared_count* count;
+        /// \brief A pointer to the listener.
+        void* listener;
+        /// \brief Calls the member function on the listener.
+        void (*invoke)(void* listener, args... arguments);
+    };
+
+    // SLOTS
+    /// \brief The contiguous array of slots.
+    slot* m_slots;
+    /// \brief The number of slots in use.
+    size_t m_size;
+    /// \brief The number of slots allocated.
+    size_t m_capacity;
+    /// \brief The depth of nested emissions in progress.
+    uint8_t m_emitting;
+    /// \brief Indicates if any slot may be dead.
+    bool m_dead;
+
+    // STORAGE
+    /// \brief Grows the slot array.
+    /// \param capacity The new number of slots to allocate.
+    void reserve(size_t capacity)
+    {
+        slot* slots = new slot[capacity];
+        for(size_t i = 0; i < event_signal::m_size; ++i)
+        {
+            slots[i] = event_signal::m_slots[i];
+        }
+        delete[] event_signal::m_slots;
+        event_signal::m_slots = slots;
+        event_signal::m_capacity = capacity;
+    }
+    /// \brief Removes the slots of disconnected and destroyed listeners, keeping the order of the others.
+    void prune()
+    {
+        if(!event_signal::m_dead)
+        {
+            return;
+        }
+
+        size_t kept = 0;
+        for(size_t i = 0; i < event_signal::m_size; ++i)
+        {
+            slot& current = event_signal::m_slots[i];
+            if(current.count && current.count->use_count() != 0)
+            {
+                event_signal::m_slots[kept++] = current;
+            }
+            else if(current.count)
+            {
+                // Release the weak reference of the destroyed listener.
+                current.count->decrement_weak_count();
+            }
+        }
+        event_signal::m_size = kept;
+        event_signal::m_dead = false;
+    }
+
+    // INVOCATION
+    /// \brief Calls a member function on a type-erased listener.
+    /// \tparam listener_type The type of the listener.
+    /// \tparam method The member function to call.
+    /// \param listener A pointer to the listener.
+    /// \param arguments The event's arguments.
+    template <class listener_type, void (listener_type::*method)(args...)>
+    static void invoke(void* listener, args... arguments)
+    {
+        (static_cast<listener_type*>(listener)->*method)(arguments...);
+    }
+};
+
+#endif
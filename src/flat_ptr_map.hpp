@@ -0,0 +1,157 @@
+/// \file flat_ptr_map.hpp
+/// \brief Defines the flat_ptr_map class.
+#ifndef SMART_PTR___FLAT_PTR_MAP_H
+#define SMART_PTR___FLAT_PTR_MAP_H
+
+#include <flat_ptr_table.hpp>
+#include <smart_ptr_check.hpp>
+
+/// \brief An entry of a flat_ptr_map, stored inline in the map's slot array.
+/// \tparam key_type The type of the key.
+/// \tparam value_type The type of the value.
+template <class key_type, class value_type>
+struct flat_ptr_entry
+{
+    /// \brief The key of the entry.
+    key_type key;
+    /// \brief The value of the entry.
+    value_type value;
+};
+/// \brief Gets the address a flat_ptr_map entry is keyed by.
+/// \tparam key_type The type of the key.
+/// \tparam value_type The type of the value.
+template <class key_type, class value_type>
+struct ptr_key<flat_ptr_entry<key_type, value_type>>
+{
+    /// \brief Gets the address of an entry's key.
+    /// \param entry The entry.
+    /// \return The address of the object the key points to, or nullptr if the entry is empty.
+    static const void* address(const flat_ptr_entry<key_type, value_type>& entry)
+    {
+        return ptr_key<key_type>::address(entry.key);
+    }
+};
+
+/// \brief A hash map keyed by the address of a pointer, with keys and values stored together in one contiguous array.
+/// \details Keys may be raw pointers, shared_ptrs, unique_ptrs, or any smart pointer with a get() member, and lookups
+/// accept any of them. Empty keys cannot be stored. Values must be default constructible and movable.
+/// \tparam key_type The type of the keys.
+/// \tparam value_type The type of the values.
+/// \tparam hash_type The type of the hash function, which hashes const void* addresses.
+template <class key_type, class value_type, class hash_type = ptr_hash>
+class flat_ptr_map
+    : public flat_ptr_table<flat_ptr_entry<key_type, value_type>, hash_type>
+{
+public:
+    // TYPES
+    /// \brief The type of the map's entries.
+    typedef flat_ptr_entry<key_type, value_type> entry_type;
+
+    // ACCESS
+    /// \brief Finds the value of the key pointing to an object.
+    /// \tparam lookup_type The type of the pointer to look up.
+    /// \param key A pointer to the object.
+    /// \return A pointer to the value, or nullptr if the map holds no key pointing to the object.
+    template <class lookup_type>
+    value_type* find(const lookup_type& key)
+    {
+        entry_type* entry = flat_ptr_map::lookup(ptr_key<lookup_type>::address(key));
+        return entry ? &entry->value : nullptr;
+    }
+    /// \brief Finds the value of the key pointing to an object.
+    /// \tparam lookup_type The type of the pointer to look up.
+    /// \param key A pointer to the object.
+    /// \return A pointer to the value, or nullptr if the map holds no key pointing to the object.
+    template <class lookup_type>
+    const value_type* find(const lookup_type& key) const
+    {
+        const entry_type* entry = flat_ptr_map::lookup(ptr_key<lookup_type>::address(key));
+        return entry ? &entry->value : nullptr;
+    }
+    /// \brief Indicates if the map holds a key pointing to an object.
+    /// \tparam lookup_type The type of the pointer to look up.
+    /// \param key A pointer to the object.
+    /// \return TRUE if the map holds a key pointing to the object, otherwise FALSE.
+    template <class lookup_type>
+    bool contains(const lookup_type& key) const
+    {
+        return flat_ptr_map::lookup(ptr_key<lookup_type>::address(key)) != nullptr;
+    }
+    /// \brief Calls a function for each entry, in unspecified order.
+    /// \tparam function_type The type of the function.
+    /// \param function The function to call with each key and value.
+    template <class function_type>
+    void for_each(function_type function)
+    {
+        for(size_t i = 0; i < flat_ptr_map::m_capacity; ++i)
+        {
+            entry_type& entry = flat_ptr_map::m_slots[i];
+            if(ptr_key<key_type>::address(entry.key))
+            {
+                function(static_cast<const key_type&>(entry.key), entry.value);
+            }
+        }
+    }
+
+    // UPDATE
+    /// \brief Gets the value of a key, inserting a default constructed value if the map holds no key pointing to the
+    /// same object.
+    /// \param key The key, which must not be empty and is moved into the map if inserted.
+    /// \return A reference to the value. For an empty key, which traps if SMART_PTR_CHECKED is defined, a reference to
+    /// a default constructed value that is not stored in the map.
+    value_type& operator[](key_type key)
+    {
+        const void* address = ptr_key<key_type>::address(key);
+        SMART_PTR_CHECK(address);
+        if(!address)
+        {
+            flat_ptr_map::m_empty_value = value_type();
+            return flat_ptr_map::m_empty_value;
+        }
+
+        bool inserted;
+        entry_type& entry = flat_ptr_map::claim(address, inserted);
+        if(inserted)
+        {
+            entry.key = static_cast<key_type&&>(key);
+        }
+        return entry.value;
+    }
+    /// \brief Inserts a key and value if the map holds no key pointing to the same object.
+    /// \param key The key to insert, which is moved into the map.
+    /// \param value The value to insert, which is moved into the map.
+    /// \return TRUE if the entry was inserted, or FALSE if the key is empty or its object is already in the map.
+    bool insert(key_type key, value_type value)
+    {
+        const void* address = ptr_key<key_type>::address(key);
+        if(!address)
+        {
+            return false;
+        }
+
+        bool inserted;
+        entry_type& entry = flat_ptr_map::claim(address, inserted);
+        if(inserted)
+        {
+            entry.key = static_cast<key_type&&>(key);
+            entry.value = static_cast<value_type&&>(value);
+        }
+        return inserted;
+    }
+    /// \brief Removes the entry of the key pointing to an object.
+    /// \tparam lookup_type The type of the pointer to look up.
+    /// \param key A pointer to the object.
+    /// \return TRUE if an entry was removed, otherwise FALSE.
+    template <class lookup_type>
+    bool erase(const lookup_type& key)
+    {
+        return flat_ptr_map::remove(ptr_key<lookup_type>::address(key));
+    }
+
+private:
+    // EMPTY KEY
+    /// \brief The value returned by operator[] for an empty key, which cannot be stored.
+    value_type m_empty_value;
+};
+
+#endif
@@ -0,0 +1,83 @@
+/// \file flat_ptr_set.hpp
+/// \brief Defines the flat_ptr_set class.
+#ifndef SMART_PTR___FLAT_PTR_SET_H
+#define SMART_PTR___FLAT_PTR_SET_H
+
+#include <flat_ptr_table.hpp>
+
+/// \brief A hash set of pointers keyed by the address they point to, stored in one contiguous array.
+/// \details Keys may be raw pointers, shared_ptrs, unique_ptrs, or any smart pointer with a get() member, and lookups
+/// accept any of them, so a set of shared_ptrs can be searched with a raw pointer. Empty keys cannot be stored.
+/// \tparam key_type The type of the keys.
+/// \tparam hash_type The type of the hash function, which hashes const void* addresses.
+template <class key_type, class hash_type = ptr_hash>
+class flat_ptr_set
+    : public flat_ptr_table<key_type, hash_type>
+{
+public:
+    // ACCESS
+    /// \brief Finds the key pointing to an object.
+    /// \tparam lookup_type The type of the pointer to look up.
+    /// \param key A pointer to the object.
+    /// \return A pointer to the stored key, or nullptr if the set holds no key pointing to the object.
+    template <class lookup_type>
+    const key_type* find(const lookup_type& key) const
+    {
+        return flat_ptr_set::lookup(ptr_key<lookup_type>::address(key));
+    }
+    /// \brief Indicates if the set holds a key pointing to an object.
+    /// \tparam lookup_type The type of the pointer to look up.
+    /// \param key A pointer to the object.
+    /// \return TRUE if the set holds a key pointing to the object, otherwise FALSE.
+    template <class lookup_type>
+    bool contains(const lookup_type& key) const
+    {
+        return flat_ptr_set::lookup(ptr_key<lookup_type>::address(key)) != nullptr;
+    }
+    /// \brief Calls a function for each key, in unspecified order.
+    /// \tparam function_type The type of the function.
+    /// \param function The function to call with each key.
+    template <class function_type>
+    void for_each(function_type function) const
+    {
+        for(size_t i = 0; i < flat_ptr_set::m_capacity; ++i)
+        {
+            if(ptr_key<key_type>::address(flat_ptr_set::m_slots[i]))
+            {
+                function(flat_ptr_set::m_slots[i]);
+            }
+        }
+    }
+
+    // UPDATE
+    /// \brief Inserts a key if the set holds no key pointing to the same object.
+    /// \param key The key to insert, which is moved into the set.
+    /// \return TRUE if the key was inserted, or FALSE if it is empty or its object is already in the set.
+    bool insert(key_type key)
+    {
+        const void* address = ptr_key<key_type>::address(key);
+        if(!address)
+        {
+            return false;
+        }
+
+        bool inserted;
+        key_type& slot = flat_ptr_set::claim(address, inserted);
+        if(inserted)
+        {
+            slot = static_cast<key_type&&>(key);
+        }
+        return inserted;
+    }
+    /// \brief Removes the key pointing to an object.
+    /// \tparam lookup_type The type of the pointer to look up.
+    /// \param key A pointer to the object.
+    /// \return TRUE if a key was removed, otherwise FALSE.
+    template <class lookup_type>
+    bool erase(const lookup_type& key)
+    {
+        return flat_ptr_set::remove(ptr_key<lookup_type>::address(key));
+    }
+};
+
+#endif
@@ -0,0 +1,246 @@
+/// \file flat_ptr_table.hpp
+/// \brief Defines the flat_ptr_table class.
+#ifndef SMART_PTR___FLAT_PTR_TABLE_H
+#define SMART_PTR___FLAT_PTR_TABLE_H
+
+#include <ptr_hash.hpp>
+
+#include <stddef.h>
+
+/// \brief The open addressing hash table shared by flat_ptr_set and flat_ptr_map.
+/// \details Slots are stored in one contiguous array and probed linearly, so a lookup usually reads a single cache
+/// line. A slot whose key is empty is free, which is why empty keys cannot be stored. Removal shifts the later
+/// slots of a probe sequence back instead of leaving tombstones, so lookups never slow down as entries churn.
+/// \tparam slot_type The type of the slots, with ptr_key<slot_type> giving the address each slot is keyed by.
+/// \tparam hash_type The type of the hash function, which hashes const void* addresses.
+template <class slot_type, class hash_type>
+class flat_ptr_table
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Creates a new, empty flat_ptr_table instance without allocating.
+    flat_ptr_table()
+        : m_slots(nullptr),
+          m_capacity(0),
+          m_size(0)
+    {}
+    /// \brief Creates a new flat_ptr_table instance, taking the slots of another.
+    /// \param other The other table, which is left empty.
+    flat_ptr_table(flat_ptr_table<slot_type, hash_type>&& other)
+        : m_slots(other.m_slots),
+          m_capacity(other.m_capacity),
+          m_size(other.m_size)
+    {
+        // Clear other's slots.
+        other.m_slots = nullptr;
+        other.m_capacity = 0;
+        other.m_size = 0;
+    }
+    flat_ptr_table(const flat_ptr_table<slot_type, hash_type>& other) = delete;
+    ~flat_ptr_table()
+    {
+        delete[] flat_ptr_table::m_slots;
+    }
+
+    // ASSIGNMENT
+    /// \brief Takes the slots of another table, releasing this table's entries.
+    /// \param other The other table, which is left empty.
+    /// \return A reference to this table.
+    flat_ptr_table<slot_type, hash_type>& operator=(flat_ptr_table<slot_type, hash_type>&& other)
+    {
+        if(this != &other)
+        {
+            delete[] flat_ptr_table::m_slots;
+            flat_ptr_table::m_slots = other.m_slots;
+            flat_ptr_table::m_capacity = other.m_capacity;
+            flat_ptr_table::m_size = other.m_size;
+
+            // Clear other's slots.
+            other.m_slots = nullptr;
+            other.m_capacity = 0;
+            other.m_size = 0;
+        }
+        return *this;
+    }
+    flat_ptr_table<slot_type, hash_type>& operator=(const flat_ptr_table<slot_type, hash_type>& other) = delete;
+
+    // CAPACITY
+    /// \brief Gets the number of entries in the table.
+    /// \return The number of entries.
+    size_t size() const
+    {
+        return flat_ptr_table::m_size;
+    }
+    /// \brief Indicates if the table contains no entries.
+    /// \return TRUE if the table is empty, otherwise FALSE.
+    bool empty() const
+    {
+        return flat_ptr_table::m_size == 0;
+    }
+    /// \brief Gets the number of slots in the table.
+    /// \return The number of slots, zero or a power of two.
+    size_t capacity() const
+    {
+        return flat_ptr_table::m_capacity;
+    }
+    /// \brief Grows the table so that it holds a number of entries without rehashing.
+    /// \param count The number of entries.
+    void reserve(size_t count)
+    {
+        size_t capacity = minimum_capacity;
+        if(flat_ptr_table::m_capacity)
+        {
+            capacity = flat_ptr_table::m_capacity;
+        }
+        while(capacity / 4 * 3 < count)
+        {
+            capacity *= 2;
+        }
+        if(capacity > flat_ptr_table::m_capacity)
+        {
+            flat_ptr_table::resize(capacity);
+        }
+    }
+    /// \brief Removes every entry, keeping the slots allocated.
+    void clear()
+    {
+        for(size_t i = 0; i < flat_ptr_table::m_capacity; ++i)
+        {
+            flat_ptr_table::m_slots[i] = slot_type();
+        }
+        flat_ptr_table::m_size = 0;
+    }
+
+protected:
+    // SLOTS
+    /// \brief The contiguous array of slots.
+    slot_type* m_slots;
+    /// \brief The number of slots, zero or a power of two.
+    size_t m_capacity;
+    /// \brief The number of occupied slots.
+    size_t m_size;
+
+    /// \brief The number of slots allocated by the first insertion.
+    static const size_t minimum_capacity = 8;
+
+    // LOOKUP
+    /// \brief Finds the slot keyed by an address.
+    /// \param address The address.
+    /// \return A pointer to the slot, or nullptr if no slot is keyed by the address.
+    slot_type* lookup(const void* address) const
+    {
+        if(!flat_ptr_table::m_capacity || !address)
+        {
+            return nullptr;
+        }
+
+        slot_type& slot = flat_ptr_table::m_slots[flat_ptr_table::find(address)];
+        return ptr_key<slot_type>::address(slot) ? &slot : nullptr;
+    }
+    /// \brief Finds the slot keyed by an address, or claims a free slot for it.
+    /// \details A claimed slot is counted as occupied, so the caller must store a key for the address in it.
+    /// \param address The address, which must not be nullptr.
+    /// \param claimed Set to TRUE if a free slot was claimed, or FALSE if the address was already in the table.
+    /// \return A reference to the slot.
+    slot_type& claim(const void* address, bool& claimed)
+    {
+        // Return the existing slot without growing.
+        if(slot_type* existing = flat_ptr_table::lookup(address))
+        {
+            claimed = false;
+            return *existing;
+        }
+
+        // Grow before the load factor exceeds 3/4.
+        if((flat_ptr_table::m_size + 1) * 4 > flat_ptr_table::m_capacity * 3)
+        {
+            size_t capacity = minimum_capacity;
+            if(flat_ptr_table::m_capacity)
+            {
+                capacity = flat_ptr_table::m_capacity * 2;
+            }
+            flat_ptr_table::resize(capacity);
+        }
+
+        claimed = true;
+        ++flat_ptr_table::m_size;
+        return flat_ptr_table::m_slots[flat_ptr_table::find(address)];
+    }
+    /// \brief Removes the slot keyed by an address.
+    /// \param address The address.
+    /// \return TRUE if a slot was removed, otherwise FALSE.
+    bool remove(const void* address)
+    {
+        slot_type* removed = flat_ptr_table::lookup(address);
+        if(!removed)
+        {
+            return false;
+        }
+
+        // Shift later slots of the probe sequence back while the emptied slot lies between their home and their slot.
+        size_t mask = flat_ptr_table::m_capacity - 1;
+        size_t slot = static_cast<size_t>(removed - flat_ptr_table::m_slots);
+        size_t next = (slot + 1) & mask;
+        while(const void* next_address = ptr_key<slot_type>::address(flat_ptr_table::m_slots[next]))
+        {
+            size_t preferred = flat_ptr_table::home(next_address);
+            if(((next - preferred) & mask) >= ((next - slot) & mask))
+            {
+                flat_ptr_table::m_slots[slot] = static_cast<slot_type&&>(flat_ptr_table::m_slots[next]);
+                slot = next;
+            }
+            next = (next + 1) & mask;
+        }
+
+        // Release the entry left in the last emptied slot.
+        flat_ptr_table::m_slots[slot] = slot_type();
+        --flat_ptr_table::m_size;
+        return true;
+    }
+
+private:
+    // PROBING
+    /// \brief Gets the preferred slot of an address.
+    /// \param address The address.
+    /// \return The index of the preferred slot.
+    size_t home(const void* address) const
+    {
+        return hash_type()(address) & (flat_ptr_table::m_capacity - 1);
+    }
+    /// \brief Finds the slot keyed by an address, or the free slot where it would be inserted.
+    /// \param address The address.
+    /// \return The index of the slot.
+    size_t find(const void* address) const
+    {
+        size_t slot = flat_ptr_table::home(address);
+        while(const void* slot_address = ptr_key<slot_type>::address(flat_ptr_table::m_slots[slot]))
+        {
+            if(slot_address == address)
+            {
+                break;
+            }
+            slot = (slot + 1) & (flat_ptr_table::m_capacity - 1);
+        }
+        return slot;
+    }
+    /// \brief Rehashes the table into a new capacity.
+    /// \param capacity The new capacity, a power of two.
+    void resize(size_t capacity)
+    {
+        slot_type* slots = flat_ptr_table::m_slots;
+        size_t old_capacity = flat_ptr_table::m_capacity;
+
+        flat_ptr_table::m_slots = new slot_type[capacity]();
+        flat_ptr_table::m_capacity = capacity;
+        for(size_t i = 0; i < old_capacity; ++i)
+        {
+            if(const void* address = ptr_key<slot_type>::address(slots[i]))
+            {
+                flat_ptr_table::m_slots[flat_ptr_table::find(address)] = static_cast<slot_type&&>(slots[i]);
+            }
+        }
+        delete[] slots;
+    }
+};
+
+#endif
@@ -0,0 +1,723 @@
+/// \file gc_ptr.hpp
+/// \brief Defines the gc_ptr class and its incremental mark-sweep collector.
+#ifndef SMART_PTR___GC_PTR_H
+#define SMART_PTR___GC_PTR_H
+
+#include <smart_ptr_check.hpp>
+
+#include <stdint.h>
+
+class gc_heap;
+class gc_object;
+template <class object_type>
+class gc_member;
+
+/// \brief Traces the gc_member references held by an object.
+/// \details Specialize this for every type that holds gc_member references, and mark each of them with
+/// gc_heap::mark(). The default treats the type as holding no references.
+/// \tparam object_type The type of the object.
+template <class object_type>
+struct gc_trace
+{
+    /// \brief Marks the gc_member references held by an object.
+    /// \param object The object to trace.
+    /// \param heap The heap performing the collection.
+    static void trace(object_type& /* object */, gc_heap& /* heap */)
+    {}
+};
+
+/// \brief Describes how the collector handles objects of one type.
+struct gc_type
+{
+    /// \brief Marks the references held by an object.
+    void (*trace)(gc_object* object, gc_heap& heap);
+    /// \brief Destroys an object and frees its memory.
+    void (*destroy)(gc_object* object);
+    /// \brief The size of an object's allocation in bytes.
+    size_t size;
+};
+
+/// \brief The collector header of an object allocated on a gc_heap.
+class gc_object
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Creates a new gc_object instance.
+    /// \param heap The heap the object belongs to.
+    /// \param type The collector description of the object's type.
+    gc_object(gc_heap& heap, const gc_type& type)
+        : m_heap(&heap),
+          m_type(&type),
+          m_next(nullptr),
+          m_gray_next(nullptr),
+          m_color(0)
+    {}
+    gc_object(const gc_object& other) = delete;
+    gc_object& operator=(const gc_object& other) = delete;
+
+    // ACCESS
+    /// \brief Gets the heap the object belongs to.
+    /// \return The heap of the object.
+    gc_heap& heap() const
+    {
+        return *gc_object::m_heap;
+    }
+
+private:
+    // COLLECTOR
+    /// \brief The heap the object belongs to.
+    gc_heap* m_heap;
+    /// \brief The collector description of the object's type.
+    const gc_type* m_type;
+    /// \brief The next object in the heap's list of all objects.
+    gc_object* m_next;
+    /// \brief The next object in the heap's list of objects waiting to be traced.
+    gc_object* m_gray_next;
+    /// \brief The mark color of the object.
+    uint8_t m_color;
+
+    friend class gc_heap;
+};
+
+/// \brief The allocation holding an object on a gc_heap.
+/// \tparam object_type The type of the object.
+template <class object_type>
+class gc_block
+    : public gc_object
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Creates a new gc_block instance.
+    /// \tparam args The variadic types of the object's constructor parameters.
+    /// \param heap The heap the object belongs to.
+    /// \param arguments The arguments to pass to the object's constructor.
+    template <class... args>
+    gc_block(gc_heap& heap, args&&... arguments)
+        : gc_object(heap, gc_block::type),
+          object(arguments...)
+    {}
+
+    /// \brief The object.
+    object_type object;
+
+    // TYPE
+    /// \brief The collector description of gc_block<object_type>.
+    static const gc_type type;
+
+private:
+    // TYPE
+    /// \brief Traces a gc_block<object_type>.
+    /// \param block The block to trace.
+    /// \param heap The heap performing the collection.
+    static void trace_block(gc_object* block, gc_heap& heap)
+    {
+        gc_trace<object_type>::trace(static_cast<gc_block*>(block)->object, heap);
+    }
+    /// \brief Destroys a gc_block<object_type>.
+    /// \param block The block to destroy.
+    static void destroy_block(gc_object* block)
+    {
+        delete static_cast<gc_block*>(block);
+    }
+};
+template <class object_type>
+const gc_type gc_block<object_type>::type = {&gc_block<object_type>::trace_block, &gc_block<object_type>::destroy_block, sizeof(gc_block<object_type>)};
+
+/// \brief A handle that keeps an object on a gc_heap reachable.
+/// \details Every non-null root is linked into the root list of its object's heap.
+class gc_root
+{
+public:
+    // CONSTRUCTORS
+    gc_root(const gc_root& other) = delete;
+    gc_root& operator=(const gc_root& other) = delete;
+
+protected:
+    // CONSTRUCTORS
+    /// \brief Creates a new, empty gc_root instance.
+    gc_root()
+        : m_target(nullptr),
+          m_previous(nullptr),
+          m_next(nullptr)
+    {}
+    ~gc_root()
+    {
+        gc_root::attach(nullptr);
+    }
+
+    // TARGET
+    /// \brief Points this root at an object.
+    /// \param target The object to keep reachable, or nullptr.
+    inline void attach(gc_object* target);
+    /// \brief The object kept reachable by this root.
+    gc_object* m_target;
+
+private:
+    // LIST
+    /// \brief The previous root in the heap's root list.
+    gc_root* m_previous;
+    /// \brief The next root in the heap's root list.
+    gc_root* m_next;
+
+    friend class gc_heap;
+};
+
+/// \brief A heap of garbage collected objects.
+/// \details Objects are reclaimed by an incremental mark-sweep collector, so unreachable cycles are freed. Each
+/// allocation performs a bounded step of collection work once enough memory has been allocated since the last
+/// cycle, and collect_step() can be called during idle time to do more.
+class gc_heap
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Creates a new gc_heap instance.
+    /// \param threshold The number of bytes to allocate after a cycle before the next cycle starts.
+    /// \param step_budget The number of objects to process per step performed by an allocation.
+    gc_heap(size_t threshold, size_t step_budget)
+        : m_objects(nullptr),
+          m_gray(nullptr),
+          m_roots(nullptr),
+          m_root_cursor(nullptr),
+          m_sweep_cursor(nullptr),
+          m_phase(phase::idle),
+          m_bytes(0),
+          m_threshold(threshold),
+          m_trigger(threshold),
+          m_step_budget(step_budget),
+          m_constructing(0)
+    {}
+    gc_heap(const gc_heap& other) = delete;
+    gc_heap& operator=(const gc_heap& other) = delete;
+    /// \details Destroys all remaining objects. No roots may reference the heap's objects afterwards.
+    ~gc_heap()
+    {
+        while(gc_heap::m_objects)
+        {
+            gc_object* object = gc_heap::m_objects;
+            gc_heap::m_objects = object->m_next;
+            object->m_type->destroy(object);
+        }
+    }
+
+    // ALLOCATION
+    /// \brief Prepares the heap for a new object, before the object is constructed.
+    /// \details Performs the collection work paced against allocation, then holds off collection until the object
+    /// is adopted. The gc_members of an object are not traced before it is adopted, so a collection step run by a
+    /// make_gc() inside its constructor could otherwise free the objects they reference.
+    void begin_allocation()
+    {
+        // Pace the collector against allocation, unless an enclosing object is still being constructed.
+        if(!gc_heap::m_constructing && (gc_heap::m_phase != phase::idle || gc_heap::m_bytes >= gc_heap::m_trigger))
+        {
+            gc_heap::collect_step(gc_heap::m_step_budget);
+        }
+        ++gc_heap::m_constructing;
+    }
+    /// \brief Adds a newly constructed object to the heap.
+    /// \param object The object to add, which must have been prepared for with begin_allocation().
+    void adopt(gc_object* object)
+    {
+        --gc_heap::m_constructing;
+
+        // Link the object at the head of the list.
+        object->m_color = color::white;
+        object->m_next = gc_heap::m_objects;
+        gc_heap::m_objects = object;
+        gc_heap::m_bytes += object->m_type->size;
+
+        // Objects created during marking are reachable, and their references may predate the cycle, so trace them.
+        gc_heap::write_barrier(object);
+
+        // Keep the sweep from visiting objects created after it started.
+        if(gc_heap::m_phase == phase::sweep && gc_heap::m_sweep_cursor == &(gc_heap::m_objects))
+        {
+            gc_heap::m_sweep_cursor = &object->m_next;
+        }
+    }
+
+    // COLLECTION
+    /// \brief Performs a bounded amount of collection work, starting a new cycle if none is in progress.
+    /// \details Must not be called while an object on the heap is being constructed.
+    /// \param budget The maximum number of roots and objects to process.
+    /// \return TRUE if the cycle finished during this step, otherwise FALSE.
+    bool collect_step(size_t budget)
+    {
+        SMART_PTR_CHECK(gc_heap::m_constructing == 0);
+
+        // Start a new cycle if idle.
+        if(gc_heap::m_phase == phase::idle)
+        {
+            gc_heap::m_phase = phase::mark_roots;
+            gc_heap::m_root_cursor = gc_heap::m_roots;
+        }
+
+        for(; budget > 0; --budget)
+        {
+            switch(gc_heap::m_phase)
+            {
+                case phase::mark_roots:
+                {
+                    // Shade the next root's object, or move on to tracing.
+                    if(gc_heap::m_root_cursor)
+                    {
+                        gc_heap::shade(gc_heap::m_root_cursor->m_target);
+                        gc_heap::m_root_cursor = gc_heap::m_root_cursor->m_next;
+                    }
+                    else
+                    {
+                        gc_heap::m_phase = phase::mark;
+                    }
+                    break;
+                }
+                case phase::mark:
+                {
+                    // Trace the next gray object, or move on to sweeping.
+                    if(gc_heap::m_gray)
+                    {
+                        gc_object* object = gc_heap::m_gray;
+                        gc_heap::m_gray = object->m_gray_next;
+                        object->m_color = color::black;
+                        object->m_type->trace(object, *this);
+                    }
+                    else
+                    {
+                        gc_heap::m_phase = phase::sweep;
+                        gc_heap::m_sweep_cursor = &(gc_heap::m_objects);
+                    }
+                    break;
+                }
+                case phase::sweep:
+                {
+                    gc_object* object = *gc_heap::m_sweep_cursor;
+
+                    // Finish the cycle at the end of the list.
+                    if(!object)
+                    {
+                        gc_heap::m_phase = phase::idle;
+                        gc_heap::m_sweep_cursor = nullptr;
+                        gc_heap::m_trigger = gc_heap::m_bytes + gc_heap::m_threshold;
+                        return true;
+                    }
+
+                    if(object->m_color == color::white)
+                    {
+                        // Free unreachable objects.
+                        *gc_heap::m_sweep_cursor = object->m_next;
+                        gc_heap::m_bytes -= object->m_type->size;
+                        object->m_type->destroy(object);
+                    }
+                    else
+                    {
+                        // Reset reachable objects for the next cycle.
+                        object->m_color = color::white;
+                        gc_heap::m_sweep_cursor = &object->m_next;
+                    }
+                    break;
+                }
+                default:
+                {
+                    break;
+                }
+            }
+        }
+
+        return false;
+    }
+    /// \brief Finishes the current cycle, if any, and then performs a complete cycle.
+    void collect()
+    {
+        if(gc_heap::m_phase != phase::idle)
+        {
+            while(!gc_heap::collect_step(static_cast<size_t>(-1)))
+            {}
+        }
+        while(!gc_heap::collect_step(static_cast<size_t>(-1)))
+        {}
+    }
+    /// \brief Marks an object referenced by a gc_member as reachable.
+    /// \details Call this from gc_trace specializations.
+    /// \tparam object_type The type of the referenced object.
+    /// \param member The reference to mark.
+    template <class object_type>
+    void mark(const gc_member<object_type>& member)
+    {
+        gc_heap::shade(member.m_block);
+    }
+
+    // STATUS
+    /// \brief Gets the number of bytes allocated by objects on the heap.
+    /// \return The number of bytes.
+    size_t bytes() const
+    {
+        return gc_heap::m_bytes;
+    }
+    /// \brief Indicates if a collection cycle is in progress.
+    /// \return TRUE if a cycle is in progress, otherwise FALSE.
+    bool collecting() const
+    {
+        return gc_heap::m_phase != phase::idle;
+    }
+
+    // BARRIER
+    /// \brief Records that a reference to an object was stored.
+    /// \details Shades the object while marking, so that no traced object references an unmarked one.
+    /// \param object The referenced object, or nullptr.
+    void write_barrier(gc_object* object)
+    {
+        if(gc_heap::marking())
+        {
+            gc_heap::shade(object);
+        }
+    }
+
+private:
+    // TYPES
+    /// \brief The phases of a collection cycle.
+    enum class phase : uint8_t
+    {
+        idle,
+        mark_roots,
+        mark,
+        sweep
+    };
+    /// \brief The mark colors of objects.
+    struct color
+    {
+        /// \brief Not yet found to be reachable.
+        static const uint8_t white = 0;
+        /// \brief Reachable, but references not yet traced.
+        static const uint8_t gray = 1;
+        /// \brief Reachable, with references traced.
+        static const uint8_t black = 2;
+    };
+
+    // OBJECTS
+    /// \brief The list of all objects on the heap.
+    gc_object* m_objects;
+    /// \brief The list of objects waiting to be traced.
+    gc_object* m_gray;
+
+    // ROOTS
+    /// \brief The list of roots referencing objects on the heap.
+    gc_root* m_roots;
+    /// \brief The next root to shade while marking roots.
+    gc_root* m_root_cursor;
+
+    // CYCLE
+    /// \brief The link to the next object to visit while sweeping.
+    gc_object** m_sweep_cursor;
+    /// \brief The current phase of the collection cycle.
+    phase m_phase;
+    /// \brief The number of bytes allocated by objects on the heap.
+    size_t m_bytes;
+    /// \brief The number of bytes to allocate after a cycle before the next cycle starts.
+    size_t m_threshold;
+    /// \brief The number of allocated bytes that starts the next cycle.
+    size_t m_trigger;
+    /// \brief The number of objects to process per step performed by an allocation.
+    size_t m_step_budget;
+    /// \brief The number of objects being constructed, during which collection is held off.
+    size_t m_constructing;
+
+    // MARKING
+    /// \brief Indicates if the collector is marking.
+    /// \return TRUE if marking, otherwise FALSE.
+    bool marking() const
+    {
+        return gc_heap::m_phase == phase::mark_roots || gc_heap::m_phase == phase::mark;
+    }
+    /// \brief Queues an unmarked object for tracing.
+    /// \param object The object, or nullptr.
+    void shade(gc_object* object)
+    {
+        if(object && object->m_color == color::white)
+        {
+            object->m_color = color::gray;
+            object->m_gray_next = gc_heap::m_gray;
+            gc_heap::m_gray = object;
+        }
+    }
+
+    // ROOTS
+    /// \brief Links a root into the root list.
+    /// \param root The root to link.
+    void link_root(gc_root* root)
+    {
+        root->m_previous = nullptr;
+        root->m_next = gc_heap::m_roots;
+        if(gc_heap::m_roots)
+        {
+            gc_heap::m_roots->m_previous = root;
+        }
+        gc_heap::m_roots = root;
+
+        // Roots created while marking are not visited by the root scan.
+        gc_heap::write_barrier(root->m_target);
+    }
+    /// \brief Unlinks a root from the root list.
+    /// \param root The root to unlink.
+    void unlink_root(gc_root* root)
+    {
+        // Keep the root scan valid.
+        if(gc_heap::m_root_cursor == root)
+        {
+            gc_heap::m_root_cursor = root->m_next;
+        }
+
+        if(root->m_previous)
+        {
+            root->m_previous->m_next = root->m_next;
+        }
+        else
+        {
+            gc_heap::m_roots = root->m_next;
+        }
+        if(root->m_next)
+        {
+            root->m_next->m_previous = root->m_previous;
+        }
+    }
+
+    friend class gc_root;
+};
+
+void gc_root::attach(gc_object* target)
+{
+    // Check if the heap changes.
+    gc_heap* previous_heap = gc_root::m_target ? &gc_root::m_target->heap() : nullptr;
+    gc_heap* heap = target ? &target->heap() : nullptr;
+    if(previous_heap == heap)
+    {
+        gc_root::m_target = target;
+        if(heap)
+        {
+            heap->write_barrier(target);
+        }
+        return;
+    }
+
+    // Move the root between heap root lists.
+    if(previous_heap)
+    {
+        previous_heap->unlink_root(this);
+    }
+    gc_root::m_target = target;
+    if(heap)
+    {
+        heap->link_root(this);
+    }
+}
+
+/// \brief A reference from one garbage collected object to another.
+/// \details gc_member references must only be stored inside objects allocated on a gc_heap, and must be marked by
+/// the gc_trace specialization of the containing type.
+/// \tparam object_type The type of the object.
+template <class object_type>
+class gc_member
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Creates a new, empty gc_member instance.
+    gc_member()
+        : m_block(nullptr)
+    {}
+    /// \brief Copy constructs from another gc_member instance.
+    /// \param other The gc_member instance to copy.
+    gc_member(const gc_member<object_type>& other)
+        : m_block(nullptr)
+    {
+        gc_member::assign(other.m_block);
+    }
+    /// \brief Creates a new gc_member instance referencing a block.
+    /// \param block The block to reference.
+    explicit gc_member(gc_block<object_type>* block)
+        : m_block(nullptr)
+    {
+        gc_member::assign(block);
+    }
+
+    // ASSIGNMENT
+    /// \brief Copy assigns this gc_member from another gc_member.
+    /// \param other The gc_member instance to copy.
+    /// \return A reference to this gc_member.
+    gc_member<object_type>& operator=(const gc_member<object_type>& other)
+    {
+        gc_member::assign(other.m_block);
+        return *this;
+    }
+
+    // ACCESS
+    /// \brief Gets the pointer to the referenced object instance.
+    /// \return A pointer to the object instance.
+    object_type* get() const
+    {
+        return gc_member::m_block ? &gc_member::m_block->object : nullptr;
+    }
+    /// \brief Dereferences the pointer to the referenced object instance.
+    /// \return A pointer to the object instance.
+    object_type* operator->() const
+    {
+        SMART_PTR_CHECK(gc_member::m_block);
+        return &gc_member::m_block->object;
+    }
+    /// \brief Dereferences the pointer to the referenced object instance.
+    /// \return A reference to the object instance.
+    object_type& operator*() const
+    {
+        SMART_PTR_CHECK(gc_member::m_block);
+        return gc_member::m_block->object;
+    }
+    /// \brief Checks if this gc_member references an object instance.
+    /// \return TRUE if this gc_member references an object instance, false if it is nullptr.
+    operator bool() const
+    {
+        return gc_member::m_block != nullptr;
+    }
+    /// \brief Gets the block holding the referenced object.
+    /// \return A pointer to the block.
+    gc_block<object_type>* block() const
+    {
+        return gc_member::m_block;
+    }
+
+private:
+    // OBJECT
+    /// \brief The block holding the referenced object.
+    gc_block<object_type>* m_block;
+
+    // BARRIER
+    /// \brief Stores a reference and notifies the collector.
+    /// \param block The block to reference.
+    void assign(gc_block<object_type>* block)
+    {
+        gc_member::m_block = block;
+        if(block)
+        {
+            block->heap().write_barrier(block);
+        }
+    }
+
+    friend class gc_heap;
+};
+
+/// \brief A smart pointer that keeps a garbage collected object reachable.
+/// \details Objects referenced by a gc_ptr, and everything they reference through gc_member, survive collection.
+/// Objects that are no longer reachable, including cycles, are freed by the heap's collector.
+/// \tparam object_type The type of the object.
+template <class object_type>
+class gc_ptr
+    : private gc_root
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Creates a new, empty gc_ptr instance.
+    gc_ptr()
+    {}
+    /// \brief Creates a new gc_ptr instance referencing a block.
+    /// \param block The block to keep reachable.
+    explicit gc_ptr(gc_block<object_type>* block)
+    {
+        gc_root::attach(block);
+    }
+    /// \brief Copy constructs from another gc_ptr instance.
+    /// \param other The gc_ptr instance to copy.
+    gc_ptr(const gc_ptr<object_type>& other)
+    {
+        gc_root::attach(other.m_target);
+    }
+    /// \brief Creates a new gc_ptr instance from a gc_member.
+    /// \param member The gc_member referencing the object to keep reachable.
+    gc_ptr(const gc_member<object_type>& member)
+    {
+        gc_root::attach(member.block());
+    }
+
+    // RESET
+    /// \brief Resets the gc_ptr to nullptr.
+    void reset()
+    {
+        gc_root::attach(nullptr);
+    }
+
+    // ASSIGNMENT
+    /// \brief Copy assigns this gc_ptr from another gc_ptr.
+    /// \param other The gc_ptr instance to copy.
+    /// \return A reference to this gc_ptr.
+    gc_ptr<object_type>& operator=(const gc_ptr<object_type>& other)
+    {
+        gc_root::attach(other.m_target);
+        return *this;
+    }
+    /// \brief Assigns this gc_ptr from a gc_member.
+    /// \param member The gc_member referencing the object to keep reachable.
+    /// \return A reference to this gc_ptr.
+    gc_ptr<object_type>& operator=(const gc_member<object_type>& member)
+    {
+        gc_root::attach(member.block());
+        return *this;
+    }
+
+    // CONVERSION
+    /// \brief Creates a gc_member referencing the same object, for storing inside another collected object.
+    /// \return A gc_member referencing the object.
+    operator gc_member<object_type>() const
+    {
+        return gc_member<object_type>(gc_ptr::block());
+    }
+
+    // ACCESS
+    /// \brief Gets the pointer to the referenced object instance.
+    /// \return A pointer to the object instance.
+    object_type* get() const
+    {
+        return gc_root::m_target ? &gc_ptr::block()->object : nullptr;
+    }
+    /// \brief Dereferences the pointer to the referenced object instance.
+    /// \return A pointer to the object instance.
+    object_type* operator->() const
+    {
+        SMART_PTR_CHECK(gc_root::m_target);
+        return &gc_ptr::block()->object;
+    }
+    /// \brief Dereferences the pointer to the referenced object instance.
+    /// \return A reference to the object instance.
+    object_type& operator*() const
+    {
+        SMART_PTR_CHECK(gc_root::m_target);
+        return gc_ptr::block()->object;
+    }
+    /// \brief Checks if this gc_ptr references an object instance.
+    /// \return TRUE if this gc_ptr references an object instance, false if it is nullptr.
+    operator bool() const
+    {
+        return gc_root::m_target != nullptr;
+    }
+
+private:
+    // OBJECT
+    /// \brief Gets the block holding the referenced object.
+    /// \return A pointer to the block.
+    gc_block<object_type>* block() const
+    {
+        return static_cast<gc_block<object_type>*>(gc_root::m_target);
+    }
+};
+
+// UTILITIES
+/// \brief Creates a gc_ptr referencing a new instance of an object on a gc_heap.
+/// \tparam object_type The type of the object.
+/// \tparam args The variadic types of the object's constructor parameters.
+/// \param heap The heap to allocate the object on.
+/// \param arguments The arguments to pass to the object's constructor.
+/// \return A gc_ptr referencing the new instance of the object.
+template <class object_type, class... args>
+gc_ptr<object_type> make_gc(gc_heap& heap, args&&... arguments)
+{
+    // Construct the object before adding it to the heap, so that collection steps never see it half-built.
+    heap.begin_allocation();
+    gc_block<object_type>* block = new gc_block<object_type>(heap, arguments...);
+    heap.adopt(block);
+    return gc_ptr<object_type>(block);
+}
+
+#endif
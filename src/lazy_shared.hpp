@@ -0,0 +1,286 @@
+/// \file lazy_shared.hpp
+/// \brief Defines the lazy_shared class.
+#ifndef SMART_PTR___LAZY_SHARED_H
+#define SMART_PTR___LAZY_SHARED_H
+
+#include <shared_ptr.hpp>
+
+#include <stddef.h>
+
+#ifndef ARDUINO
+#include <atomic>
+#include <mutex>
+#endif
+
+/// \brief Gets the type a lazy constructor argument is stored as.
+/// \details Arrays and functions cannot be stored by value, so they are stored as pointers, as std::decay would. A
+/// stored array, such as a string literal, must therefore outlive the lazy object.
+/// \tparam argument_type The type of the argument.
+template <class argument_type>
+struct lazy_stored
+{
+    /// \brief The stored type.
+    typedef argument_type type;
+};
+/// \brief Stores an array argument as a pointer to its first element.
+/// \tparam element_type The type of the array's elements.
+/// \tparam size The number of elements.
+template <class element_type, size_t size>
+struct lazy_stored<element_type[size]>
+{
+    /// \brief The stored type.
+    typedef const element_type* type;
+};
+/// \brief Stores a function argument as a function pointer.
+/// \tparam result_type The result type of the function.
+/// \tparam parameters The parameter types of the function.
+template <class result_type, class... parameters>
+struct lazy_stored<result_type(parameters...)>
+{
+    /// \brief The stored type.
+    typedef result_type (*type)(parameters...);
+};
+
+/// \brief Stores constructor arguments for an object that has not been created yet.
+/// \tparam object_type The type of the object.
+/// \tparam args The types of the stored constructor arguments.
+template <class object_type, class... args>
+struct lazy_arguments;
+
+/// \brief Stores an empty set of constructor arguments.
+/// \tparam object_type The type of the object.
+template <class object_type>
+struct lazy_arguments<object_type>
+{
+    /// \brief Creates the object from the arguments unpacked so far.
+    /// \tparam unpacked The types of the unpacked arguments.
+    /// \param arguments The unpacked arguments.
+    /// \return A shared_ptr managing the new object.
+    template <class... unpacked>
+    shared_ptr<object_type> construct(const unpacked&... arguments) const
+    {
+        return make_shared<object_type>(arguments...);
+    }
+    /// \brief Creates the object from the stored arguments.
+    /// \return A shared_ptr managing the new object.
+    shared_ptr<object_type> operator()() const
+    {
+        return lazy_arguments::construct();
+    }
+};
+
+/// \brief Stores a non-empty set of constructor arguments.
+/// \tparam object_type The type of the object.
+/// \tparam first The type of the first stored argument.
+/// \tparam rest The types of the remaining stored arguments.
+template <class object_type, class first, class... rest>
+struct lazy_arguments<object_type, first, rest...>
+{
+    /// \brief Creates a new lazy_arguments instance.
+    /// \param first_argument The first argument.
+    /// \param rest_arguments The remaining arguments.
+    lazy_arguments(const first& first_argument, const rest&... rest_arguments)
+        : m_first(first_argument),
+          m_rest(rest_arguments...)
+    {}
+
+    /// \brief Creates the object from the arguments unpacked so far.
+    /// \tparam unpacked The types of the unpacked arguments.
+    /// \param arguments The unpacked arguments.
+    /// \return A shared_ptr managing the new object.
+    template <class... unpacked>
+    shared_ptr<object_type> construct(const unpacked&... arguments) const
+    {
+        // Append this argument and continue unpacking.
+        return lazy_arguments::m_rest.construct(arguments..., lazy_arguments::m_first);
+    }
+    /// \brief Creates the object from the stored arguments.
+    /// \return A shared_ptr managing the new object.
+    shared_ptr<object_type> operator()() const
+    {
+        return lazy_arguments::construct();
+    }
+
+    /// \brief The first stored argument.
+    first m_first;
+    /// \brief The remaining stored arguments.
+    lazy_arguments<object_type, rest...> m_rest;
+};
+
+/// \brief A shared_ptr whose object is created through a factory on first access.
+/// \tparam object_type The type of the object.
+/// \tparam factory_type The type of the factory. Must be callable with no arguments and return a shared_ptr<object_type>.
+template <class object_type, class factory_type = shared_ptr<object_type>(*)()>
+class lazy_shared
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Creates a new lazy_shared instance that default constructs the object.
+    lazy_shared()
+        : m_factory(&make_shared<object_type>)
+    {}
+    /// \brief Creates a new lazy_shared instance.
+    /// \param factory The factory that creates the object on first access.
+    lazy_shared(const factory_type& factory)
+        : m_factory(factory)
+    {}
+    /// \brief Move constructs from another lazy_shared instance.
+    /// \param other The lazy_shared instance to move.
+    lazy_shared(lazy_shared<object_type, factory_type>&& other)
+        : m_factory(other.m_factory),
+          m_pointer(static_cast<shared_ptr<object_type>&&>(other.m_pointer)),
+          m_constructed(other.m_constructed)
+    {}
+    lazy_shared(const lazy_shared<object_type, factory_type>& other) = delete;
+    lazy_shared<object_type, factory_type>& operator=(const lazy_shared<object_type, factory_type>& other) = delete;
+
+    // ACCESS
+    /// \brief Gets the shared_ptr managing the object, creating the object if needed.
+    /// \return A reference to the shared_ptr managing the object.
+    const shared_ptr<object_type>& shared()
+    {
+        // Create the object on first access.
+        if(!lazy_shared::m_constructed)
+        {
+            lazy_shared::m_pointer = lazy_shared::m_factory();
+            lazy_shared::m_constructed = true;
+        }
+
+        return lazy_shared::m_pointer;
+    }
+    /// \brief Gets the pointer to the object, creating the object if needed.
+    /// \return A pointer to the object instance.
+    object_type* get()
+    {
+        return lazy_shared::shared().get();
+    }
+    /// \brief Dereferences the pointer to the object, creating the object if needed.
+    /// \return A pointer to the object instance.
+    object_type* operator->()
+    {
+        return lazy_shared::shared().get();
+    }
+    /// \brief Dereferences the pointer to the object, creating the object if needed.
+    /// \return A reference to the object instance.
+    object_type& operator*()
+    {
+        return *lazy_shared::shared();
+    }
+    /// \brief Indicates if the object has been created.
+    /// \return TRUE if the factory has been invoked, otherwise FALSE.
+    bool is_constructed() const
+    {
+        return lazy_shared::m_constructed;
+    }
+
+private:
+    // FACTORY
+    /// \brief The factory that creates the object.
+    factory_type m_factory;
+
+    // OBJECT
+    /// \brief The shared_ptr managing the object once it has been created.
+    shared_ptr<object_type> m_pointer;
+    /// \brief Indicates if the factory has been invoked.
+    bool m_constructed = false;
+};
+
+#ifndef ARDUINO
+/// \brief A thread-safe lazy_shared for hosted builds.
+/// \details The factory runs at most once, even if several threads access the object concurrently.
+/// \tparam object_type The type of the object.
+/// \tparam factory_type The type of the factory. Must be callable with no arguments and return a shared_ptr<object_type>.
+template <class object_type, class factory_type = shared_ptr<object_type>(*)()>
+class lazy_shared_sync
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Creates a new lazy_shared_sync instance that default constructs the object.
+    lazy_shared_sync()
+        : m_factory(&make_shared<object_type>)
+    {}
+    /// \brief Creates a new lazy_shared_sync instance.
+    /// \param factory The factory that creates the object on first access.
+    lazy_shared_sync(const factory_type& factory)
+        : m_factory(factory)
+    {}
+    lazy_shared_sync(const lazy_shared_sync<object_type, factory_type>& other) = delete;
+    lazy_shared_sync<object_type, factory_type>& operator=(const lazy_shared_sync<object_type, factory_type>& other) = delete;
+
+    // ACCESS
+    /// \brief Gets the shared_ptr managing the object, creating the object if needed.
+    /// \details Only the creation is thread safe. Copies of the returned shared_ptr use the library's non-atomic
+    /// counts, so every copy must be made and released on one thread.
+    /// \return A reference to the shared_ptr managing the object.
+    const shared_ptr<object_type>& shared()
+    {
+        // Only take the lock if the object has not been published yet.
+        if(!lazy_shared_sync::m_constructed.load(std::memory_order_acquire))
+        {
+            std::lock_guard<std::mutex> lock(lazy_shared_sync::m_mutex);
+
+            // Check again in case another thread created the object while waiting.
+            if(!lazy_shared_sync::m_constructed.load(std::memory_order_relaxed))
+            {
+                lazy_shared_sync::m_pointer = lazy_shared_sync::m_factory();
+                lazy_shared_sync::m_constructed.store(true, std::memory_order_release);
+            }
+        }
+
+        return lazy_shared_sync::m_pointer;
+    }
+    /// \brief Gets the pointer to the object, creating the object if needed.
+    /// \return A pointer to the object instance.
+    object_type* get()
+    {
+        return lazy_shared_sync::shared().get();
+    }
+    /// \brief Dereferences the pointer to the object, creating the object if needed.
+    /// \return A pointer to the object instance.
+    object_type* operator->()
+    {
+        return lazy_shared_sync::shared().get();
+    }
+    /// \brief Dereferences the pointer to the object, creating the object if needed.
+    /// \return A reference to the object instance.
+    object_type& operator*()
+    {
+        return *lazy_shared_sync::shared();
+    }
+    /// \brief Indicates if the object has been created.
+    /// \return TRUE if the factory has been invoked, otherwise FALSE.
+    bool is_constructed() const
+    {
+        return lazy_shared_sync::m_constructed.load(std::memory_order_acquire);
+    }
+
+private:
+    // FACTORY
+    /// \brief The factory that creates the object.
+    factory_type m_factory;
+    /// \brief Serializes invocation of the factory.
+    std::mutex m_mutex;
+
+    // OBJECT
+    /// \brief The shared_ptr managing the object once it has been created.
+    shared_ptr<object_type> m_pointer;
+    /// \brief Indicates if the factory has been invoked and the object has been published.
+    std::atomic<bool> m_constructed{false};
+};
+#endif
+
+// UTILITIES
+/// \brief Creates a lazy_shared that constructs the object from the given arguments on first access.
+/// \tparam object_type The type of the object.
+/// \tparam args The types of the object's constructor parameters.
+/// \param arguments The arguments to store and later pass to the object's constructor. Arrays and functions are
+/// stored as pointers.
+/// \return A lazy_shared that stores the arguments.
+template <class object_type, class... args>
+lazy_shared<object_type, lazy_arguments<object_type, typename lazy_stored<args>::type...>> make_lazy_shared(const args&... arguments)
+{
+    typedef lazy_arguments<object_type, typename lazy_stored<args>::type...> arguments_type;
+    return lazy_shared<object_type, arguments_type>(arguments_type(arguments...));
+}
+
+#endif
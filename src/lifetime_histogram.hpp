@@ -0,0 +1,377 @@
+/// \file lifetime_histogram.hpp
+/// \brief Defines the lifetime_histogram class.
+#ifndef SMART_PTR___LIFETIME_HISTOGRAM_H
+#define SMART_PTR___LIFETIME_HISTOGRAM_H
+
+#include <smart_ptr_clock.hpp>
+#include <smart_ptr_type.hpp>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifndef ARDUINO
+#include <mutex>
+#endif
+
+/// \brief A log-scale histogram of how long the objects of one type lived, from allocation to final release.
+/// \details Enabled by defining SMART_PTR_LIFETIME before including the library. Bucket i counts the objects that
+/// lived for less than 2^(i+1) microseconds and at least 2^i microseconds (bucket 0 also counts shorter lifetimes,
+/// and the last bucket counts every longer one), so short-lived types that suit a pool and long-lived types that suit
+/// static allocation stand apart. Creation times are kept in an address-keyed hash table until the object is
+/// released. SMART_PTR_CLOCK() wraps after about 71 minutes, so the wraps are counted to extend it to 64 bits; this
+/// requires at least one allocation or release between wraps.
+class lifetime_histogram
+{
+public:
+    // TYPES
+    /// \brief The type of a function that writes dumped text, for example to a file or a serial port.
+    typedef void (*writer_type)(const char* text, void* context);
+    /// \brief The number of buckets. The last bucket holds every lifetime of 2^31 microseconds or more.
+    static const uint8_t bucket_count = 32;
+
+    // QUERY
+    /// \brief Gets the histogram of a type.
+    /// \param type The type.
+    /// \return A pointer to the histogram, or nullptr if no object of the type has been released yet.
+    static const lifetime_histogram* of(const smart_ptr_type& type)
+    {
+        state& lifetimes = lifetime_histogram::get_state();
+        lifetime_histogram::lock(lifetimes);
+        const lifetime_histogram* histogram = type.index() < lifetimes.histogram_count ? lifetimes.histograms[type.index()] : nullptr;
+        lifetime_histogram::unlock(lifetimes);
+        return histogram;
+    }
+    /// \brief Gets the number of released objects whose lifetime fell into a bucket.
+    /// \param index The index of the bucket, less than bucket_count.
+    /// \return The number of objects.
+    uint32_t bucket(uint8_t index) const
+    {
+        return lifetime_histogram::m_buckets[index];
+    }
+    /// \brief Gets the number of released objects.
+    /// \return The number of objects.
+    uint32_t count() const
+    {
+        uint32_t total = 0;
+        for(uint8_t i = 0; i < lifetime_histogram::bucket_count; ++i)
+        {
+            total += lifetime_histogram::m_buckets[i];
+        }
+        return total;
+    }
+    /// \brief Estimates a percentile of the lifetimes.
+    /// \param percent The percentile, from 0 to 100.
+    /// \return The upper bound in microseconds of the bucket containing the percentile.
+    uint32_t percentile(uint8_t percent) const
+    {
+        uint32_t target = static_cast<uint32_t>((static_cast<uint64_t>(lifetime_histogram::count()) * percent + 99) / 100);
+        uint32_t seen = 0;
+        for(uint8_t i = 0; i < lifetime_histogram::bucket_count; ++i)
+        {
+            seen += lifetime_histogram::m_buckets[i];
+            if(seen >= target && seen != 0)
+            {
+                return i < 31 ? (uint32_t(2) << i) - 1 : UINT32_MAX;
+            }
+        }
+        return 0;
+    }
+
+    // OUTPUT
+    /// \brief Writes the histograms of all types that have released objects, one line per type.
+    /// \details Each line holds the type name, the median and 99th percentile bounds, and the non-empty buckets as
+    /// "<upper bound in microseconds>:<count>".
+    /// \param writer The function that writes the text.
+    /// \param context The context passed to the writer.
+    static void dump(writer_type writer, void* context)
+    {
+        state& lifetimes = lifetime_histogram::get_state();
+        lifetime_histogram::lock(lifetimes);
+        char text[48];
+        for(smart_ptr_type* type = smart_ptr_type::first(); type; type = type->next())
+        {
+            if(type->index() >= lifetimes.histogram_count || !lifetimes.histograms[type->index()])
+            {
+                continue;
+            }
+            const lifetime_histogram& histogram = *lifetimes.histograms[type->index()];
+
+            // Write the name and summary.
+            snprintf(text, sizeof(text), "%.*s", type->name_length() < 40 ? type->name_length() : 40, type->name());
+            writer(text, context);
+            snprintf(text, sizeof(text), " n=%lu p50<%lu p99<%lu |", static_cast<unsigned long>(histogram.count()),
+                     static_cast<unsigned long>(histogram.percentile(50)), static_cast<unsigned long>(histogram.percentile(99)));
+            writer(text, context);
+
+            // Write the non-empty buckets.
+            for(uint8_t i = 0; i < lifetime_histogram::bucket_count; ++i)
+            {
+                if(histogram.m_buckets[i])
+                {
+                    snprintf(text, sizeof(text), " %lu:%lu", static_cast<unsigned long>(i < 31 ? (uint32_t(2) << i) - 1 : UINT32_MAX),
+                             static_cast<unsigned long>(histogram.m_buckets[i]));
+                    writer(text, context);
+                }
+            }
+            writer("\n", context);
+        }
+        lifetime_histogram::unlock(lifetimes);
+    }
+#ifndef ARDUINO
+    /// \brief Writes the histograms of all types that have released objects to a file.
+    /// \param file The file to write to.
+    static void dump(FILE* file)
+    {
+        lifetime_histogram::dump(&lifetime_histogram::write_file, file);
+    }
+#endif
+
+    // HOOKS
+    /// \brief Records the creation time of an object.
+    /// \param type The type of the object.
+    /// \param address The address of the object.
+    static void allocate(const smart_ptr_type& type, const void* address)
+    {
+        state& lifetimes = lifetime_histogram::get_state();
+        lifetime_histogram::lock(lifetimes);
+
+        // Grow the table when it would become more than three quarters full.
+        if((lifetimes.size + 1) * 4 > lifetimes.capacity * 3)
+        {
+            lifetime_histogram::resize(lifetimes, lifetimes.capacity ? lifetimes.capacity * 2 : 16);
+        }
+
+        // Insert the object, replacing a stale entry at the same address.
+        size_t slot = lifetime_histogram::find(lifetimes, address);
+        if(!lifetimes.entries[slot].address)
+        {
+            ++lifetimes.size;
+        }
+        lifetimes.entries[slot].address = address;
+        lifetimes.entries[slot].created = lifetime_histogram::now(lifetimes);
+        lifetimes.entries[slot].type = type.index();
+
+        lifetime_histogram::unlock(lifetimes);
+    }
+    /// \brief Records the lifetime of a released object in the histogram of its type.
+    /// \param address The address of the object.
+    static void free(const void* address)
+    {
+        state& lifetimes = lifetime_histogram::get_state();
+        lifetime_histogram::lock(lifetimes);
+        if(!lifetimes.capacity)
+        {
+            lifetime_histogram::unlock(lifetimes);
+            return;
+        }
+
+        size_t slot = lifetime_histogram::find(lifetimes, address);
+        if(lifetimes.entries[slot].address)
+        {
+            // Add the lifetime to the bucket of its base-2 logarithm, clamping long lifetimes to the last bucket.
+            uint64_t lifetime = lifetime_histogram::now(lifetimes) - lifetimes.entries[slot].created;
+            uint8_t index = 0;
+            while((lifetime >>= 1) && index < lifetime_histogram::bucket_count - 1)
+            {
+                ++index;
+            }
+            ++lifetime_histogram::get_histogram(lifetimes, lifetimes.entries[slot].type).m_buckets[index];
+
+            lifetime_histogram::erase(lifetimes, slot);
+        }
+
+        lifetime_histogram::unlock(lifetimes);
+    }
+
+private:
+    // CONSTRUCTORS
+    /// \brief Creates a new, empty lifetime_histogram instance.
+    lifetime_histogram()
+        : m_buckets()
+    {}
+
+    // BUCKETS
+    /// \brief The number of objects released in each bucket.
+    uint32_t m_buckets[bucket_count];
+
+    // STATE
+    /// \brief The creation time of a live object.
+    struct entry
+    {
+        /// \brief The address of the object, or nullptr if the entry is empty.
+        const void* address;
+        /// \brief The time the object was created, extended to 64 bits.
+        uint64_t created;
+        /// \brief The index of the type of the object.
+        uint16_t type;
+    };
+    /// \brief The state of the lifetime instrumentation.
+    struct state
+    {
+        /// \brief The open addressing hash table of live objects.
+        entry* entries;
+        /// \brief The number of entries in the table, zero or a power of two.
+        size_t capacity;
+        /// \brief The number of live objects in the table.
+        size_t size;
+        /// \brief The histograms by type index.
+        lifetime_histogram** histograms;
+        /// \brief The number of elements in the histograms array.
+        uint16_t histogram_count;
+        /// \brief The clock reading of the last allocation or release.
+        uint32_t clock;
+        /// \brief The number of times the clock has wrapped.
+        uint32_t wraps;
+#ifndef ARDUINO
+        /// \brief Serializes the instrumentation across threads.
+        std::mutex mutex;
+#endif
+    };
+    /// \brief Gets the state of the lifetime instrumentation.
+    /// \return A reference to the state.
+    static state& get_state()
+    {
+        static state lifetimes = {};
+        return lifetimes;
+    }
+    /// \brief Locks the state. Does nothing on Arduino.
+    /// \param lifetimes The state.
+    static void lock(state& lifetimes)
+    {
+#ifndef ARDUINO
+        lifetimes.mutex.lock();
+#endif
+    }
+    /// \brief Unlocks the state. Does nothing on Arduino.
+    /// \param lifetimes The state.
+    static void unlock(state& lifetimes)
+    {
+#ifndef ARDUINO
+        lifetimes.mutex.unlock();
+#endif
+    }
+
+    // CLOCK
+    /// \brief Reads SMART_PTR_CLOCK(), extended to 64 bits by counting the times it wrapped since the last reading.
+    /// \param lifetimes The state.
+    /// \return The time in microseconds.
+    static uint64_t now(state& lifetimes)
+    {
+        uint32_t clock = SMART_PTR_CLOCK();
+        if(clock < lifetimes.clock)
+        {
+            ++lifetimes.wraps;
+        }
+        lifetimes.clock = clock;
+        return (static_cast<uint64_t>(lifetimes.wraps) << 32) | clock;
+    }
+
+    // HISTOGRAMS
+    /// \brief Gets the histogram of a type, creating it if it does not exist.
+    /// \param lifetimes The state.
+    /// \param type The index of the type.
+    /// \return A reference to the histogram.
+    static lifetime_histogram& get_histogram(state& lifetimes, uint16_t type)
+    {
+        // Grow the array to cover all registered types.
+        if(type >= lifetimes.histogram_count)
+        {
+            uint16_t count = smart_ptr_type::count();
+            lifetime_histogram** histograms = new lifetime_histogram*[count]();
+            for(uint16_t i = 0; i < lifetimes.histogram_count; ++i)
+            {
+                histograms[i] = lifetimes.histograms[i];
+            }
+            delete[] lifetimes.histograms;
+            lifetimes.histograms = histograms;
+            lifetimes.histogram_count = count;
+        }
+
+        if(!lifetimes.histograms[type])
+        {
+            lifetimes.histograms[type] = new lifetime_histogram();
+        }
+        return *lifetimes.histograms[type];
+    }
+
+    // TABLE
+    /// \brief Gets the preferred slot of an address.
+    /// \param lifetimes The state.
+    /// \param address The address.
+    /// \return The index of the preferred slot.
+    static size_t home(const state& lifetimes, const void* address)
+    {
+        uint32_t hash = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(address) >> 2);
+        hash ^= hash >> 16;
+        hash *= 0x85EBCA6B;
+        hash ^= hash >> 13;
+        return hash & (lifetimes.capacity - 1);
+    }
+    /// \brief Finds the slot holding an address, or the empty slot where it would be inserted.
+    /// \param lifetimes The state.
+    /// \param address The address.
+    /// \return The index of the slot.
+    static size_t find(const state& lifetimes, const void* address)
+    {
+        size_t slot = lifetime_histogram::home(lifetimes, address);
+        while(lifetimes.entries[slot].address && lifetimes.entries[slot].address != address)
+        {
+            slot = (slot + 1) & (lifetimes.capacity - 1);
+        }
+        return slot;
+    }
+    /// \brief Removes an entry, shifting later entries of its probe sequence back so that lookups stay correct.
+    /// \param lifetimes The state.
+    /// \param slot The index of the entry.
+    static void erase(state& lifetimes, size_t slot)
+    {
+        size_t mask = lifetimes.capacity - 1;
+        size_t next = (slot + 1) & mask;
+        while(lifetimes.entries[next].address)
+        {
+            // Move the entry back if the emptied slot lies between its home and its current slot.
+            size_t preferred = lifetime_histogram::home(lifetimes, lifetimes.entries[next].address);
+            if(((next - preferred) & mask) >= ((next - slot) & mask))
+            {
+                lifetimes.entries[slot] = lifetimes.entries[next];
+                slot = next;
+            }
+            next = (next + 1) & mask;
+        }
+        lifetimes.entries[slot].address = nullptr;
+        --lifetimes.size;
+    }
+    /// \brief Rehashes the table into a new capacity.
+    /// \param lifetimes The state.
+    /// \param capacity The new capacity, a power of two.
+    static void resize(state& lifetimes, size_t capacity)
+    {
+        entry* entries = lifetimes.entries;
+        size_t old_capacity = lifetimes.capacity;
+
+        lifetimes.entries = new entry[capacity]();
+        lifetimes.capacity = capacity;
+        for(size_t i = 0; i < old_capacity; ++i)
+        {
+            if(entries[i].address)
+            {
+                lifetimes.entries[lifetime_histogram::find(lifetimes, entries[i].address)] = entries[i];
+            }
+        }
+        delete[] entries;
+    }
+
+#ifndef ARDUINO
+    // OUTPUT
+    /// \brief Writes text to a file.
+    /// \param text The text to write.
+    /// \param context The FILE to write to.
+    static void write_file(const char* text, void* context)
+    {
+        fputs(text, static_cast<FILE*>(context));
+    }
+#endif
+};
+
+#endif
@@ -0,0 +1,389 @@
+/// \file memory_telemetry.hpp
+/// \brief Defines the memory_telemetry class.
+#ifndef SMART_PTR___MEMORY_TELEMETRY_H
+#define SMART_PTR___MEMORY_TELEMETRY_H
+
+#ifndef ARDUINO
+
+#include <smart_ptr_type.hpp>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifndef SMART_PTR_TELEMETRY_TYPES
+/// \brief The number of types tracked individually. Types registered after these are combined into the last entry.
+/// May be defined before including the library, and must match in the publisher and the reader.
+#define SMART_PTR_TELEMETRY_TYPES 64
+#endif
+
+/// \brief Publishes periodic snapshots of the memory held by the smart pointers into a POSIX shared-memory ring, so
+/// that a separate process can watch a running program.
+/// \details Enabled by defining SMART_PTR_TELEMETRY before including the library, on hosted builds only. The hooks
+/// only update per-type atomic counters, and publishing writes the next slot of the ring under a sequence lock that
+/// readers retry on, so neither the program's threads nor the publisher ever wait for a reader. extras/smart_ptr_top
+/// displays the snapshots.
+class memory_telemetry
+{
+public:
+    // LAYOUT
+    /// \brief The value of region::magic, "SPM1".
+    static const uint32_t magic = 0x314D5053;
+    /// \brief The number of snapshots in the ring.
+    static const uint32_t slot_count = 8;
+    /// \brief The size of a type name in a snapshot, including the null terminator.
+    static const uint32_t name_size = 64;
+    /// \brief The memory of one type in a snapshot.
+    struct type_snapshot
+    {
+        /// \brief The null terminated name of the type.
+        char name[name_size];
+        /// \brief The number of live objects.
+        uint64_t live_objects;
+        /// \brief The number of live bytes.
+        uint64_t live_bytes;
+        /// \brief The number of objects allocated since the program started.
+        uint64_t allocations;
+        /// \brief The number of bytes allocated since the program started.
+        uint64_t allocated_bytes;
+    };
+    /// \brief A snapshot of the memory of all types.
+    struct snapshot
+    {
+        /// \brief The sequence number of the snapshot, starting at 1.
+        uint64_t sequence;
+        /// \brief The steady clock time of the snapshot in nanoseconds.
+        uint64_t time;
+        /// \brief The number of live objects of all types.
+        uint64_t live_objects;
+        /// \brief The number of live bytes of all types.
+        uint64_t live_bytes;
+        /// \brief The allocations per second since the previous snapshot.
+        double allocation_rate;
+        /// \brief The bytes allocated per second since the previous snapshot.
+        double byte_rate;
+        /// \brief The number of valid entries in types.
+        uint32_t type_count;
+        /// \brief The memory of each type, by type index.
+        type_snapshot types[SMART_PTR_TELEMETRY_TYPES];
+    };
+    /// \brief A slot of the ring.
+    struct slot
+    {
+        /// \brief The sequence lock of the slot: odd while the snapshot is being written.
+        std::atomic<uint64_t> version;
+        /// \brief The snapshot.
+        snapshot data;
+    };
+    /// \brief The layout of the shared memory.
+    struct region
+    {
+        /// \brief Set to magic once the region is initialized.
+        std::atomic<uint32_t> magic;
+        /// \brief The value of SMART_PTR_TELEMETRY_TYPES in the publisher.
+        uint32_t type_capacity;
+        /// \brief The process id of the publisher.
+        uint32_t pid;
+        /// \brief The sequence number of the latest complete snapshot, stored in slots[published % slot_count].
+        std::atomic<uint64_t> published;
+        /// \brief The ring of snapshots.
+        slot slots[slot_count];
+    };
+
+    // PUBLISHING
+    /// \brief Creates the shared memory and starts publishing snapshots. Call stop() before the program exits.
+    /// \param name The name of the shared memory object, for example "/my_program".
+    /// \param period_ms The milliseconds between snapshots published by a background thread, or 0 to publish only
+    /// when publish() is called.
+    /// \return TRUE if the shared memory was created, otherwise FALSE.
+    static bool start(const char* name, uint32_t period_ms = 1000)
+    {
+        state& telemetry = memory_telemetry::get_state();
+        std::lock_guard<std::mutex> lock(telemetry.control);
+        if(telemetry.shared)
+        {
+            return false;
+        }
+
+        // Create and map the shared memory.
+        int descriptor = shm_open(name, O_CREAT | O_RDWR, 0644);
+        if(descriptor < 0)
+        {
+            return false;
+        }
+        void* mapping = MAP_FAILED;
+        if(ftruncate(descriptor, sizeof(region)) == 0)
+        {
+            mapping = mmap(nullptr, sizeof(region), PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+        }
+        close(descriptor);
+        if(mapping == MAP_FAILED)
+        {
+            shm_unlink(name);
+            return false;
+        }
+
+        // Initialize the region, publishing the magic last.
+        region* shared = new(mapping) region();
+        shared->type_capacity = SMART_PTR_TELEMETRY_TYPES;
+        shared->pid = static_cast<uint32_t>(getpid());
+        shared->published.store(0, std::memory_order_relaxed);
+        for(uint32_t i = 0; i < slot_count; ++i)
+        {
+            shared->slots[i].version.store(0, std::memory_order_relaxed);
+        }
+        shared->magic.store(memory_telemetry::magic, std::memory_order_release);
+        strncpy(telemetry.name, name, sizeof(telemetry.name) - 1);
+        telemetry.previous_time = memory_telemetry::now();
+        telemetry.shared = shared;
+
+        // Start the background publisher.
+        if(period_ms)
+        {
+            telemetry.running = true;
+            telemetry.publisher = std::thread([&telemetry, period_ms]()
+            {
+                std::unique_lock<std::mutex> wait(telemetry.control);
+                while(!telemetry.stopped.wait_for(wait, std::chrono::milliseconds(period_ms), [&telemetry]() { return !telemetry.running; }))
+                {
+                    memory_telemetry::publish_snapshot(telemetry);
+                }
+            });
+        }
+
+        return true;
+    }
+    /// \brief Publishes a snapshot now.
+    /// \return TRUE if a snapshot was published, or FALSE if telemetry is not started or another snapshot is being
+    /// published.
+    static bool publish()
+    {
+        state& telemetry = memory_telemetry::get_state();
+        std::unique_lock<std::mutex> lock(telemetry.control, std::try_to_lock);
+        if(!lock.owns_lock() || !telemetry.shared)
+        {
+            return false;
+        }
+        memory_telemetry::publish_snapshot(telemetry);
+        return true;
+    }
+    /// \brief Stops the background publisher, unmaps the shared memory and removes it.
+    static void stop()
+    {
+        state& telemetry = memory_telemetry::get_state();
+
+        // Stop the background publisher.
+        {
+            std::lock_guard<std::mutex> lock(telemetry.control);
+            telemetry.running = false;
+        }
+        telemetry.stopped.notify_all();
+        if(telemetry.publisher.joinable())
+        {
+            telemetry.publisher.join();
+        }
+
+        // Remove the shared memory.
+        std::lock_guard<std::mutex> lock(telemetry.control);
+        if(telemetry.shared)
+        {
+            munmap(telemetry.shared, sizeof(region));
+            shm_unlink(telemetry.name);
+            telemetry.shared = nullptr;
+        }
+    }
+
+    // HOOKS
+    /// \brief Counts an allocation.
+    /// \param type The type of the allocation.
+    /// \param size The size of the allocation in bytes.
+    static void allocate(const smart_ptr_type& type, size_t size)
+    {
+        counters& counted = memory_telemetry::counters_of(type);
+        counted.live_objects.fetch_add(1, std::memory_order_relaxed);
+        counted.live_bytes.fetch_add(size, std::memory_order_relaxed);
+        counted.allocations.fetch_add(1, std::memory_order_relaxed);
+        counted.allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    }
+    /// \brief Counts a free.
+    /// \param type The type of the allocation.
+    /// \param size The size of the allocation in bytes.
+    static void free(const smart_ptr_type& type, size_t size)
+    {
+        counters& counted = memory_telemetry::counters_of(type);
+        counted.live_objects.fetch_sub(1, std::memory_order_relaxed);
+        counted.live_bytes.fetch_sub(size, std::memory_order_relaxed);
+    }
+
+    // READING
+    /// \brief Reads the latest snapshot from a mapped region, retrying while the publisher overwrites it.
+    /// \param shared The mapped region.
+    /// \param output The snapshot to read into.
+    /// \return TRUE if a snapshot was read, or FALSE if none has been published yet.
+    static bool read(const region& shared, snapshot& output)
+    {
+        while(true)
+        {
+            uint64_t published = shared.published.load(std::memory_order_acquire);
+            if(published == 0)
+            {
+                return false;
+            }
+
+            // Copy the slot, and accept the copy if it was not overwritten meanwhile.
+            const slot& latest = shared.slots[published % slot_count];
+            uint64_t version = latest.version.load(std::memory_order_acquire);
+            if(version & 1)
+            {
+                continue;
+            }
+            memcpy(&output, &latest.data, sizeof(snapshot));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(latest.version.load(std::memory_order_relaxed) == version && output.sequence == published)
+            {
+                return true;
+            }
+        }
+    }
+
+private:
+    // STATE
+    /// \brief The live counters of a type.
+    struct counters
+    {
+        /// \brief The number of live objects.
+        std::atomic<uint64_t> live_objects;
+        /// \brief The number of live bytes.
+        std::atomic<uint64_t> live_bytes;
+        /// \brief The number of objects allocated.
+        std::atomic<uint64_t> allocations;
+        /// \brief The number of bytes allocated.
+        std::atomic<uint64_t> allocated_bytes;
+    };
+    /// \brief The state of the telemetry.
+    struct state
+    {
+        /// \brief The counters by type index.
+        counters types[SMART_PTR_TELEMETRY_TYPES];
+        /// \brief The mapped shared memory, or nullptr if telemetry is not started.
+        region* shared;
+        /// \brief The name of the shared memory object.
+        char name[256];
+        /// \brief The time of the previous snapshot in nanoseconds.
+        uint64_t previous_time;
+        /// \brief The number of allocations at the previous snapshot.
+        uint64_t previous_allocations;
+        /// \brief The number of bytes allocated at the previous snapshot.
+        uint64_t previous_bytes;
+        /// \brief The sequence number of the previous snapshot.
+        uint64_t sequence;
+        /// \brief TRUE while the background publisher should run.
+        bool running;
+        /// \brief The background publisher.
+        std::thread publisher;
+        /// \brief Serializes starting, stopping and publishing.
+        std::mutex control;
+        /// \brief Wakes the background publisher when it is stopped.
+        std::condition_variable stopped;
+    };
+    /// \brief Gets the state of the telemetry.
+    /// \return A reference to the state.
+    static state& get_state()
+    {
+        static state telemetry = {};
+        return telemetry;
+    }
+    /// \brief Gets the counters of a type.
+    /// \param type The type.
+    /// \return A reference to the counters, shared by all types past SMART_PTR_TELEMETRY_TYPES.
+    static counters& counters_of(const smart_ptr_type& type)
+    {
+        uint16_t index = type.index() < SMART_PTR_TELEMETRY_TYPES ? type.index() : SMART_PTR_TELEMETRY_TYPES - 1;
+        return memory_telemetry::get_state().types[index];
+    }
+    /// \brief Gets the steady clock time.
+    /// \return The time in nanoseconds.
+    static uint64_t now()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    // PUBLISHING
+    /// \brief Writes a snapshot into the next slot of the ring. The control mutex must be held.
+    /// \param telemetry The state.
+    static void publish_snapshot(state& telemetry)
+    {
+        region& shared = *telemetry.shared;
+        uint64_t sequence = ++telemetry.sequence;
+        slot& next = shared.slots[sequence % slot_count];
+
+        // Mark the slot as being written.
+        uint64_t version = next.version.load(std::memory_order_relaxed);
+        next.version.store(version + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        // Copy the counters and the names of the registered types.
+        snapshot& data = next.data;
+        memset(&data, 0, sizeof(snapshot));
+        data.sequence = sequence;
+        data.time = memory_telemetry::now();
+        uint16_t type_count = smart_ptr_type::count();
+        data.type_count = type_count < SMART_PTR_TELEMETRY_TYPES ? type_count : SMART_PTR_TELEMETRY_TYPES;
+        uint64_t allocations = 0;
+        uint64_t allocated_bytes = 0;
+        for(uint32_t i = 0; i < data.type_count; ++i)
+        {
+            type_snapshot& entry = data.types[i];
+            entry.live_objects = telemetry.types[i].live_objects.load(std::memory_order_relaxed);
+            entry.live_bytes = telemetry.types[i].live_bytes.load(std::memory_order_relaxed);
+            entry.allocations = telemetry.types[i].allocations.load(std::memory_order_relaxed);
+            entry.allocated_bytes = telemetry.types[i].allocated_bytes.load(std::memory_order_relaxed);
+            data.live_objects += entry.live_objects;
+            data.live_bytes += entry.live_bytes;
+            allocations += entry.allocations;
+            allocated_bytes += entry.allocated_bytes;
+        }
+        for(smart_ptr_type* type = smart_ptr_type::first(); type; type = type->next())
+        {
+            if(type->index() < data.type_count)
+            {
+                size_t length = type->name_length() < name_size - 1 ? type->name_length() : name_size - 1;
+                memcpy(data.types[type->index()].name, type->name(), length);
+            }
+        }
+        if(type_count > SMART_PTR_TELEMETRY_TYPES)
+        {
+            strcpy(data.types[SMART_PTR_TELEMETRY_TYPES - 1].name, "(other types)");
+        }
+
+        // Compute the rates since the previous snapshot.
+        double elapsed = static_cast<double>(data.time - telemetry.previous_time) / 1e9;
+        if(elapsed > 0)
+        {
+            data.allocation_rate = static_cast<double>(allocations - telemetry.previous_allocations) / elapsed;
+            data.byte_rate = static_cast<double>(allocated_bytes - telemetry.previous_bytes) / elapsed;
+        }
+        telemetry.previous_time = data.time;
+        telemetry.previous_allocations = allocations;
+        telemetry.previous_bytes = allocated_bytes;
+
+        // Complete the slot and make it the latest.
+        next.version.store(version + 2, std::memory_order_release);
+        shared.published.store(sequence, std::memory_order_release);
+    }
+};
+
+#endif
+
+#endif
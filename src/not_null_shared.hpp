@@ -0,0 +1,113 @@
+/// \file not_null_shared.hpp
+/// \brief Defines the not_null_shared class.
+#ifndef SMART_PTR___NOT_NULL_SHARED_H
+#define SMART_PTR___NOT_NULL_SHARED_H
+
+#include <shared_ptr.hpp>
+
+template <class object_type>
+class not_null_shared;
+template <class object_type, class... args>
+not_null_shared<object_type> make_not_null_shared(args&&... arguments);
+
+/// \brief A shared_ptr that always references an object.
+/// \details A not_null_shared can only be created by make_not_null_shared() or by the checked conversion from a
+/// shared_ptr, and it has no empty state: moving from it copies, so the source keeps referencing the object.
+/// Dereferencing never needs a null check.
+/// \tparam object_type The type of the object.
+template <class object_type>
+class not_null_shared
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Creates a new not_null_shared instance from a shared_ptr, trapping if it is empty.
+    /// \param pointer The shared_ptr to share ownership with.
+    explicit not_null_shared(const shared_ptr<object_type>& pointer)
+        : m_pointer(pointer)
+    {
+        // Reject empty pointers in every build, since nothing downstream checks again.
+        if(!not_null_shared::m_pointer)
+        {
+            SMART_PTR_TRAP();
+        }
+    }
+    /// \brief Copy constructs from another not_null_shared instance.
+    /// \details Also used for moves, so that the source never becomes empty.
+    /// \param other The not_null_shared instance to copy.
+    not_null_shared(const not_null_shared<object_type>& other)
+        : m_pointer(other.m_pointer)
+    {}
+
+    // ASSIGNMENT
+    /// \brief Copy assigns this not_null_shared from another not_null_shared.
+    /// \details Also used for moves, so that the source never becomes empty.
+    /// \param other The not_null_shared instance to copy.
+    /// \return A reference to this not_null_shared.
+    not_null_shared<object_type>& operator=(const not_null_shared<object_type>& other)
+    {
+        not_null_shared::m_pointer = other.m_pointer;
+        return *this;
+    }
+
+    // ACCESS
+    /// \brief Gets the pointer to the managed object instance.
+    /// \return A pointer to the object instance, which is never nullptr.
+    object_type* get() const
+    {
+        return not_null_shared::m_pointer.get();
+    }
+    /// \brief Dereferences the pointer to the managed object instance.
+    /// \return A pointer to the object instance.
+    object_type* operator->() const
+    {
+        return not_null_shared::m_pointer.get();
+    }
+    /// \brief Dereferences the pointer to the managed object instance.
+    /// \return A reference to the object instance.
+    object_type& operator*() const
+    {
+        return *not_null_shared::m_pointer;
+    }
+    /// \brief Gets the shared_ptr that shares ownership of the object.
+    /// \return A reference to the shared_ptr, which is never empty.
+    const shared_ptr<object_type>& shared() const
+    {
+        return not_null_shared::m_pointer;
+    }
+    /// \brief Converts to a shared_ptr that shares ownership of the object.
+    /// \return A reference to the shared_ptr, which is never empty.
+    operator const shared_ptr<object_type>&() const
+    {
+        return not_null_shared::m_pointer;
+    }
+
+private:
+    // CONSTRUCTORS
+    /// \brief Creates a new not_null_shared instance from a shared_ptr known to be non-empty.
+    /// \param pointer The shared_ptr to take over.
+    /// \param unchecked Distinguishes this constructor from the checked conversion.
+    not_null_shared(shared_ptr<object_type>&& pointer, bool /* unchecked */)
+        : m_pointer(static_cast<shared_ptr<object_type>&&>(pointer))
+    {}
+
+    // OBJECT
+    /// \brief The shared_ptr managing the object.
+    shared_ptr<object_type> m_pointer;
+
+    template <class other_type, class... args>
+    friend not_null_shared<other_type> make_not_null_shared(args&&... arguments);
+};
+
+// UTILITIES
+/// \brief Creates a not_null_shared managing a new instance of an object.
+/// \tparam object_type The type of the object.
+/// \tparam args The variadic types of the object's constructor parameters.
+/// \param arguments The arguments to pass to the object's constructor.
+/// \return A not_null_shared managing a new instance of the object.
+template <class object_type, class... args>
+not_null_shared<object_type> make_not_null_shared(args&&... arguments)
+{
+    return not_null_shared<object_type>(make_shared<object_type>(arguments...), true);
+}
+
+#endif
@@ -0,0 +1,118 @@
+/// \file not_null_unique.hpp
+/// \brief Defines the not_null_unique class.
+#ifndef SMART_PTR___NOT_NULL_UNIQUE_H
+#define SMART_PTR___NOT_NULL_UNIQUE_H
+
+#include <unique_ptr.hpp>
+#include <smart_ptr_check.hpp>
+
+template <class object_type>
+class not_null_unique;
+template <class object_type, class... args>
+not_null_unique<object_type> make_not_null_unique(args&&... arguments);
+
+/// \brief A unique_ptr that always references an object.
+/// \details A not_null_unique can only be created by make_not_null_unique() or by the checked conversion from a
+/// unique_ptr, and dereferencing never needs a null check. Moving ownership out consumes the source: accessors
+/// only bind to lvalues, so a moved-from expression cannot be dereferenced, and when SMART_PTR_CHECKED is defined
+/// dereferencing a moved-from variable traps.
+/// \tparam object_type The type of the object.
+template <class object_type>
+class not_null_unique
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Creates a new not_null_unique instance from a unique_ptr, trapping if it is empty.
+    /// \param pointer The unique_ptr to take ownership from.
+    explicit not_null_unique(unique_ptr<object_type>&& pointer)
+        : m_pointer(static_cast<unique_ptr<object_type>&&>(pointer))
+    {
+        // Reject empty pointers in every build, since nothing downstream checks again.
+        if(!not_null_unique::m_pointer)
+        {
+            SMART_PTR_TRAP();
+        }
+    }
+    /// \brief Move constructs from another not_null_unique instance, which must not be used afterwards.
+    /// \param other The not_null_unique instance to move.
+    not_null_unique(not_null_unique<object_type>&& other)
+        : m_pointer(static_cast<unique_ptr<object_type>&&>(other.m_pointer))
+    {}
+    not_null_unique(const not_null_unique<object_type>& other) = delete;
+
+    // ASSIGNMENT
+    /// \brief Move assigns this not_null_unique from another not_null_unique, which must not be used afterwards.
+    /// \param other The not_null_unique instance to move.
+    /// \return A reference to this not_null_unique.
+    not_null_unique<object_type>& operator=(not_null_unique<object_type>&& other)
+    {
+        not_null_unique::m_pointer = static_cast<unique_ptr<object_type>&&>(other.m_pointer);
+        return *this;
+    }
+    not_null_unique<object_type>& operator=(const not_null_unique<object_type>& other) = delete;
+
+    // ACCESS
+    /// \brief Gets the pointer to the managed object instance.
+    /// \return A pointer to the object instance, which is never nullptr.
+    object_type* get() const &
+    {
+        SMART_PTR_CHECK(not_null_unique::m_pointer);
+        return not_null_unique::m_pointer.get();
+    }
+    /// \brief Dereferences the pointer to the managed object instance.
+    /// \return A pointer to the object instance.
+    object_type* operator->() const &
+    {
+        SMART_PTR_CHECK(not_null_unique::m_pointer);
+        return not_null_unique::m_pointer.get();
+    }
+    /// \brief Dereferences the pointer to the managed object instance.
+    /// \return A reference to the object instance.
+    object_type& operator*() const &
+    {
+        SMART_PTR_CHECK(not_null_unique::m_pointer);
+        return *not_null_unique::m_pointer;
+    }
+    object_type* get() const && = delete;
+    object_type* operator->() const && = delete;
+    object_type& operator*() const && = delete;
+
+    // CONVERSION
+    /// \brief Moves ownership of the object into a unique_ptr, consuming this not_null_unique.
+    /// \return A unique_ptr managing the object.
+    unique_ptr<object_type> into_unique() &&
+    {
+        SMART_PTR_CHECK(not_null_unique::m_pointer);
+        return static_cast<unique_ptr<object_type>&&>(not_null_unique::m_pointer);
+    }
+
+private:
+    // CONSTRUCTORS
+    /// \brief Creates a new not_null_unique instance from a pointer known to be non-null.
+    /// \param pointer The pointer to the object instance to manage.
+    /// \param unchecked Distinguishes this constructor from the checked conversion.
+    not_null_unique(object_type* pointer, bool /* unchecked */)
+        : m_pointer(pointer)
+    {}
+
+    // OBJECT
+    /// \brief The unique_ptr managing the object.
+    unique_ptr<object_type> m_pointer;
+
+    template <class other_type, class... args>
+    friend not_null_unique<other_type> make_not_null_unique(args&&... arguments);
+};
+
+// UTILITIES
+/// \brief Creates a not_null_unique managing a new instance of an object.
+/// \tparam object_type The type of the object.
+/// \tparam args The variadic types of the object's constructor parameters.
+/// \param arguments The arguments to pass to the object's constructor.
+/// \return A not_null_unique managing a new instance of the object.
+template <class object_type, class... args>
+not_null_unique<object_type> make_not_null_unique(args&&... arguments)
+{
+    return not_null_unique<object_type>(new object_type(arguments...), true);
+}
+
+#endif
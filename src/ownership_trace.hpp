@@ -0,0 +1,314 @@
+/// \file ownership_trace.hpp
+/// \brief Defines the ownership_trace class.
+#ifndef SMART_PTR___OWNERSHIP_TRACE_H
+#define SMART_PTR___OWNERSHIP_TRACE_H
+
+#ifndef ARDUINO
+
+#include <smart_ptr_type.hpp>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifndef SMART_PTR_EVENT_TRACE_CAPACITY
+/// \brief The number of events each thread's buffer holds between flushes. May be defined before including the library.
+#define SMART_PTR_EVENT_TRACE_CAPACITY 16384
+#endif
+
+/// \brief Records allocation, free, copy, move and last-release events of the smart pointers, for viewing alongside
+/// other spans in chrome://tracing or Perfetto.
+/// \details Enabled by defining SMART_PTR_EVENT_TRACE before including the library, on hosted builds only. Each
+/// thread writes into its own single-producer ring buffer without locks; when a buffer is full, events are dropped
+/// and counted instead of blocking. flush() drains every buffer into a Chrome JSON trace, and frees the buffers of
+/// threads that have exited once their events are written. Timestamps are taken from
+/// std::chrono::steady_clock, which is CLOCK_MONOTONIC on Linux, and on Linux the process and thread ids are the
+/// operating system's, so the events line up with spans recorded by other tracers.
+class ownership_trace
+{
+public:
+    // TYPES
+    /// \brief The kinds of events.
+    enum class kind : uint8_t
+    {
+        /// \brief The library took ownership of a new allocation.
+        allocate,
+        /// \brief The library freed an allocation.
+        free,
+        /// \brief A shared_ptr was copied.
+        copy,
+        /// \brief A shared_ptr or unique_ptr was moved.
+        move,
+        /// \brief The last shared_ptr to an object was released.
+        release
+    };
+
+    // RECORDING
+    /// \brief Records an event into the calling thread's buffer.
+    /// \param what The kind of the event.
+    /// \param type The type of the object.
+    /// \param address The address of the object.
+    /// \param size The size of the allocation in bytes, or 0 for events other than allocate and free.
+    static void record(kind what, const smart_ptr_type& type, const void* address, size_t size)
+    {
+        // Drop events recorded while the thread exits, after its buffer was retired.
+        buffer* owned = ownership_trace::local_buffer();
+        if(!owned)
+        {
+            return;
+        }
+        buffer& local = *owned;
+
+        // Drop the event if the buffer is full.
+        size_t head = local.head.load(std::memory_order_relaxed);
+        if(head - local.tail.load(std::memory_order_acquire) == SMART_PTR_EVENT_TRACE_CAPACITY)
+        {
+            local.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        // Write the event and publish it to the flushing thread.
+        event& added = local.events[head % SMART_PTR_EVENT_TRACE_CAPACITY];
+        added.time = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+        added.address = address;
+        added.type = &type;
+        added.size = static_cast<uint32_t>(size);
+        added.what = what;
+        local.head.store(head + 1, std::memory_order_release);
+    }
+
+    // OUTPUT
+    /// \brief Drains the buffers of all threads into a Chrome JSON trace.
+    /// \param file The file to write the trace to.
+    /// \return The number of events written.
+    static size_t flush(FILE* file)
+    {
+        static std::mutex flushing;
+        std::lock_guard<std::mutex> lock(flushing);
+
+        static const char* const names[] = {"allocate", "free", "copy", "move", "release"};
+        size_t written = 0;
+        uint64_t dropped = 0;
+        fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+        buffer* previous = nullptr;
+        buffer* current = ownership_trace::buffers().load(std::memory_order_acquire);
+        while(current)
+        {
+            // Check for retirement first, so that the head read after it is final.
+            bool retired = current->retired.load(std::memory_order_acquire);
+            size_t head = current->head.load(std::memory_order_acquire);
+            size_t tail = current->tail.load(std::memory_order_relaxed);
+            for(; tail != head; ++tail)
+            {
+                const event& flushed = current->events[tail % SMART_PTR_EVENT_TRACE_CAPACITY];
+                fprintf(file, "%s\n{\"name\":\"%s ", written ? "," : "", names[static_cast<uint8_t>(flushed.what)]);
+                ownership_trace::write_escaped(file, flushed.type->name(), flushed.type->name_length());
+                fprintf(file, "\",\"cat\":\"smart_ptr\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%llu.%03u,\"pid\":%lu,\"tid\":%lu,"
+                        "\"args\":{\"address\":\"%p\",\"size\":%lu}}",
+                        static_cast<unsigned long long>(flushed.time / 1000), static_cast<unsigned>(flushed.time % 1000),
+                        ownership_trace::process_id(), current->thread, flushed.address, static_cast<unsigned long>(flushed.size));
+                ++written;
+            }
+            current->tail.store(head, std::memory_order_release);
+            dropped += current->dropped.exchange(0, std::memory_order_relaxed);
+
+            // Free the drained buffer of a thread that has exited.
+            buffer* next = current->next;
+            if(retired)
+            {
+                ownership_trace::unlink(previous, current);
+                delete current;
+            }
+            else
+            {
+                previous = current;
+            }
+            current = next;
+        }
+        fprintf(file, "],\"otherData\":{\"dropped_events\":\"%llu\"}}\n", static_cast<unsigned long long>(dropped));
+
+        return written;
+    }
+    /// \brief Drains the buffers of all threads into a Chrome JSON trace file.
+    /// \param path The path of the file to create.
+    /// \return TRUE if the file was written, otherwise FALSE.
+    static bool flush(const char* path)
+    {
+        FILE* file = fopen(path, "w");
+        if(!file)
+        {
+            return false;
+        }
+        ownership_trace::flush(file);
+        return fclose(file) == 0;
+    }
+
+private:
+    // BUFFERS
+    /// \brief A recorded event.
+    struct event
+    {
+        /// \brief The steady clock time in nanoseconds.
+        uint64_t time;
+        /// \brief The address of the object.
+        const void* address;
+        /// \brief The type of the object.
+        const smart_ptr_type* type;
+        /// \brief The size of the allocation in bytes.
+        uint32_t size;
+        /// \brief The kind of the event.
+        kind what;
+    };
+    /// \brief The ring buffer of one thread, written only by that thread and drained only by flush().
+    struct buffer
+    {
+        /// \brief The events.
+        event events[SMART_PTR_EVENT_TRACE_CAPACITY];
+        /// \brief The number of events written.
+        std::atomic<size_t> head;
+        /// \brief The number of events drained.
+        std::atomic<size_t> tail;
+        /// \brief The number of events dropped since the last flush.
+        std::atomic<uint64_t> dropped;
+        /// \brief Set once the thread has exited and will write no more events.
+        std::atomic<bool> retired;
+        /// \brief The id of the thread.
+        unsigned long thread;
+        /// \brief The buffer of the previously registered thread.
+        buffer* next;
+    };
+    /// \brief Gets the list of all threads' buffers.
+    /// \return A reference to the most recently registered buffer.
+    static std::atomic<buffer*>& buffers()
+    {
+        static std::atomic<buffer*> head(nullptr);
+        return head;
+    }
+    /// \brief Owns the buffer of one thread, and retires it when the thread exits.
+    struct owner
+    {
+        /// \brief The buffer, or nullptr if none has been registered yet.
+        buffer* local;
+        /// \brief Set once the thread has exited.
+        bool exited;
+
+        /// \brief Retires the buffer, so that flush() frees it once its events are written.
+        ~owner()
+        {
+            if(owner::local)
+            {
+                owner::local->retired.store(true, std::memory_order_release);
+            }
+            owner::local = nullptr;
+            owner::exited = true;
+        }
+    };
+    /// \brief Gets the calling thread's buffer, registering a new one on first use.
+    /// \details The buffer is retired when the thread exits, and flush() frees it after writing its events.
+    /// \return A pointer to the buffer, or nullptr if the thread is exiting and its buffer was retired.
+    static buffer* local_buffer()
+    {
+        static thread_local owner current = {nullptr, false};
+        buffer*& local = current.local;
+        if(!local && !current.exited)
+        {
+            local = new buffer();
+            local->head.store(0, std::memory_order_relaxed);
+            local->tail.store(0, std::memory_order_relaxed);
+            local->dropped.store(0, std::memory_order_relaxed);
+            local->retired.store(false, std::memory_order_relaxed);
+            local->thread = ownership_trace::thread_id();
+
+            // Push the buffer onto the list.
+            local->next = ownership_trace::buffers().load(std::memory_order_relaxed);
+            while(!ownership_trace::buffers().compare_exchange_weak(local->next, local, std::memory_order_release, std::memory_order_relaxed))
+            {}
+        }
+        return local;
+    }
+    /// \brief Removes a buffer from the list. Only called by flush(), which serializes removals.
+    /// \param previous The buffer before it in the list when it was visited, or nullptr if it was the first.
+    /// \param removed The buffer to remove.
+    static void unlink(buffer* previous, buffer* removed)
+    {
+        // Threads only push at the front, so a buffer after the first keeps its predecessor.
+        if(previous)
+        {
+            previous->next = removed->next;
+            return;
+        }
+        buffer* expected = removed;
+        if(ownership_trace::buffers().compare_exchange_strong(expected, removed->next, std::memory_order_acq_rel))
+        {
+            return;
+        }
+
+        // Buffers were pushed in front of it since, so find its new predecessor.
+        buffer* current = expected;
+        while(current->next != removed)
+        {
+            current = current->next;
+        }
+        current->next = removed->next;
+    }
+
+    // IDENTIFIERS
+    /// \brief Gets the id of the process.
+    /// \return The process id on Linux, otherwise 1.
+    static unsigned long process_id()
+    {
+#if defined(__linux__)
+        return static_cast<unsigned long>(getpid());
+#else
+        return 1;
+#endif
+    }
+    /// \brief Gets the id of the calling thread.
+    /// \return The operating system's thread id on Linux, otherwise a sequential id.
+    static unsigned long thread_id()
+    {
+#if defined(__linux__)
+        return static_cast<unsigned long>(syscall(SYS_gettid));
+#else
+        static std::atomic<unsigned long> next(1);
+        return next.fetch_add(1, std::memory_order_relaxed);
+#endif
+    }
+
+    // JSON
+    /// \brief Writes a string with the characters that JSON requires escaped.
+    /// \details Quotes and backslashes are preceded by a backslash, and control characters are written as \\u00XX.
+    /// \param file The file to write to.
+    /// \param text The characters to write.
+    /// \param length The number of characters to write.
+    static void write_escaped(FILE* file, const char* text, size_t length)
+    {
+        for(size_t i = 0; i < length; ++i)
+        {
+            unsigned char character = static_cast<unsigned char>(text[i]);
+            if(character < 0x20)
+            {
+                fprintf(file, "\\u%04x", character);
+                continue;
+            }
+            if(character == '"' || character == '\\')
+            {
+                fputc('\\', file);
+            }
+            fputc(character, file);
+        }
+    }
+};
+
+#endif
+
+#endif
@@ -0,0 +1,592 @@
+/// \file persistent_map.hpp
+/// \brief Defines the persistent_map class.
+#ifndef SMART_PTR___PERSISTENT_MAP_H
+#define SMART_PTR___PERSISTENT_MAP_H
+
+#include <shared_ptr.hpp>
+#include <trailing.hpp>
+
+#include <new>
+#include <stdint.h>
+
+/// \brief The default hash function for persistent_map keys.
+/// \details Supports integral, enum, and pointer keys. Specialize for other key types.
+/// \tparam key_type The type of the keys.
+template <class key_type>
+struct persistent_hash
+{
+    /// \brief Hashes a key.
+    /// \param key The key to hash.
+    /// \return The 32-bit hash of the key.
+    uint32_t operator()(const key_type& key) const
+    {
+        return persistent_hash::mix(static_cast<uint32_t>(key));
+    }
+    /// \brief Mixes the bits of a value so that every input bit affects every output bit.
+    /// \param value The value to mix.
+    /// \return The mixed value.
+    static uint32_t mix(uint32_t value)
+    {
+        value ^= value >> 16;
+        value *= 0x85EBCA6BUL;
+        value ^= value >> 13;
+        value *= 0xC2B2AE35UL;
+        value ^= value >> 16;
+        return value;
+    }
+};
+
+/// \brief The default hash function for pointer keys.
+/// \tparam object_type The type the pointer key points to.
+template <class object_type>
+struct persistent_hash<object_type*>
+{
+    /// \brief Hashes a key.
+    /// \param key The key to hash.
+    /// \return The 32-bit hash of the key.
+    uint32_t operator()(object_type* key) const
+    {
+        uintptr_t address = reinterpret_cast<uintptr_t>(key);
+        return persistent_hash<uint32_t>::mix(static_cast<uint32_t>(address ^ (address >> 16 >> 16)));
+    }
+};
+
+/// \brief A node of a persistent_map hash array mapped trie.
+/// \details Each node stores up to 32 entries and 32 child nodes, selected by 5 bits of the key's hash. Nodes
+/// below the last hash level store colliding entries as an unordered list. Nodes are never modified once shared.
+/// The entries and child nodes are stored directly after the node, and the counts, node, and slots share one
+/// allocation, so create nodes with create() rather than constructing them directly.
+/// \tparam key_type The type of the keys.
+/// \tparam value_type The type of the values.
+template <class key_type, class value_type>
+class alignas(key_type) alignas(value_type) alignas(shared_ptr<key_type>) persistent_map_node
+{
+public:
+    // TYPES
+    /// \brief A key/value pair stored in a node.
+    struct entry
+    {
+        /// \brief The key.
+        key_type key;
+        /// \brief The value.
+        value_type value;
+    };
+
+    // CONSTRUCTORS
+    /// \brief Creates a new node with value-initialized slots.
+    /// \param entry_map The hash fragments of the node's entries.
+    /// \param child_map The hash fragments of the node's children.
+    /// \param entry_count The number of entries.
+    /// \param child_count The number of children.
+    persistent_map_node(uint32_t entry_map, uint32_t child_map, uint8_t entry_count, uint8_t child_count)
+        : m_entry_map(entry_map),
+          m_child_map(child_map),
+          m_entry_count(entry_count),
+          m_child_count(child_count)
+    {
+        for(uint8_t i = 0; i < entry_count; ++i)
+        {
+            new (persistent_map_node::entries() + i) entry();
+        }
+        for(uint8_t i = 0; i < child_count; ++i)
+        {
+            new (persistent_map_node::children() + i) shared_ptr<persistent_map_node>();
+        }
+    }
+    persistent_map_node(const persistent_map_node<key_type, value_type>& other) = delete;
+    persistent_map_node<key_type, value_type>& operator=(const persistent_map_node<key_type, value_type>& other) = delete;
+    ~persistent_map_node()
+    {
+        // Destroy slots in reverse order of construction.
+        for(uint8_t i = persistent_map_node::m_child_count; i > 0; --i)
+        {
+            persistent_map_node::children()[i - 1].~shared_ptr<persistent_map_node>();
+        }
+        for(uint8_t i = persistent_map_node::m_entry_count; i > 0; --i)
+        {
+            persistent_map_node::entries()[i - 1].~entry();
+        }
+    }
+
+    // CREATION
+    /// \brief Creates a new node with value-initialized slots in a single allocation.
+    /// \param entry_map The hash fragments of the node's entries.
+    /// \param child_map The hash fragments of the node's children.
+    /// \param entry_count The number of entries.
+    /// \param child_count The number of children.
+    /// \return A shared_ptr to the new node.
+    static shared_ptr<persistent_map_node> create(uint32_t entry_map, uint32_t child_map, uint8_t entry_count, uint8_t child_count)
+    {
+        size_t bytes = persistent_map_node::children_offset(entry_count) + child_count * sizeof(shared_ptr<persistent_map_node>);
+        return make_shared_trailing<persistent_map_node>(bytes, entry_map, child_map, entry_count, child_count);
+    }
+
+    // SLOTS
+    /// \brief The bitmap of hash fragments stored as entries.
+    uint32_t m_entry_map;
+    /// \brief The bitmap of hash fragments stored as child nodes.
+    uint32_t m_child_map;
+    /// \brief The number of entries.
+    uint8_t m_entry_count;
+    /// \brief The number of child nodes.
+    uint8_t m_child_count;
+
+    /// \brief Gets the entries, ordered by hash fragment.
+    /// \return A pointer to the first entry.
+    entry* entries()
+    {
+        return reinterpret_cast<entry*>(this + 1);
+    }
+    /// \brief Gets the entries, ordered by hash fragment.
+    /// \return A pointer to the first entry.
+    const entry* entries() const
+    {
+        return reinterpret_cast<const entry*>(this + 1);
+    }
+    /// \brief Gets the child nodes, ordered by hash fragment.
+    /// \return A pointer to the first child node.
+    shared_ptr<persistent_map_node>* children()
+    {
+        return reinterpret_cast<shared_ptr<persistent_map_node>*>(reinterpret_cast<uint8_t*>(this + 1) + persistent_map_node::children_offset(persistent_map_node::m_entry_count));
+    }
+    /// \brief Gets the child nodes, ordered by hash fragment.
+    /// \return A pointer to the first child node.
+    const shared_ptr<persistent_map_node>* children() const
+    {
+        return reinterpret_cast<const shared_ptr<persistent_map_node>*>(reinterpret_cast<const uint8_t*>(this + 1) + persistent_map_node::children_offset(persistent_map_node::m_entry_count));
+    }
+
+private:
+    // LAYOUT
+    /// \brief Gets the offset of the child nodes from the end of the node.
+    /// \param entry_count The number of entries.
+    /// \return The size of the entries, rounded up to the alignment of the child nodes.
+    static size_t children_offset(uint8_t entry_count)
+    {
+        const size_t alignment = alignof(shared_ptr<persistent_map_node>);
+        return (entry_count * sizeof(entry) + alignment - 1) / alignment * alignment;
+    }
+};
+
+/// \brief An immutable hash map that shares structure between versions.
+/// \details Entries are stored in a hash array mapped trie of shared_ptr nodes. Copying a persistent_map is O(1),
+/// and each update copies only the O(log n) nodes on the path to the changed entry.
+/// \tparam key_type The type of the keys. Must be default constructible, copy assignable, and equality comparable.
+/// \tparam value_type The type of the values. Must be default constructible and copy assignable.
+/// \tparam hash_type The type of the hash function.
+template <class key_type, class value_type, class hash_type = persistent_hash<key_type>>
+class persistent_map
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Creates a new, empty persistent_map instance.
+    persistent_map()
+        : m_size(0)
+    {}
+
+    // ACCESS
+    /// \brief Gets the number of entries in the map.
+    /// \return The number of entries.
+    size_t size() const
+    {
+        return persistent_map::m_size;
+    }
+    /// \brief Indicates if the map contains no entries.
+    /// \return TRUE if the map is empty, otherwise FALSE.
+    bool empty() const
+    {
+        return persistent_map::m_size == 0;
+    }
+    /// \brief Finds the value for a key.
+    /// \param key The key to find.
+    /// \return A pointer to the value, or nullptr if the key is not in the map.
+    const value_type* find(const key_type& key) const
+    {
+        const uint32_t hash = hash_type()(key);
+
+        // Walk down the trie.
+        const node_type* node = persistent_map::m_root.get();
+        for(uint8_t shift = 0; node; shift += bits)
+        {
+            // Search collision nodes linearly.
+            if(shift >= hash_bits)
+            {
+                for(uint8_t i = 0; i < node->m_entry_count; ++i)
+                {
+                    if(node->entries()[i].key == key)
+                    {
+                        return &node->entries()[i].value;
+                    }
+                }
+                return nullptr;
+            }
+
+            const uint32_t bit = persistent_map::fragment_bit(hash, shift);
+            if(node->m_entry_map & bit)
+            {
+                const entry_type& entry = node->entries()[persistent_map::slot(node->m_entry_map, bit)];
+                return entry.key == key ? &entry.value : nullptr;
+            }
+            if(!(node->m_child_map & bit))
+            {
+                return nullptr;
+            }
+            node = node->children()[persistent_map::slot(node->m_child_map, bit)].get();
+        }
+
+        return nullptr;
+    }
+    /// \brief Indicates if the map contains a key.
+    /// \param key The key to find.
+    /// \return TRUE if the key is in the map, otherwise FALSE.
+    bool contains(const key_type& key) const
+    {
+        return persistent_map::find(key) != nullptr;
+    }
+    /// \brief Calls a function for each entry, in unspecified order.
+    /// \tparam function_type The type of the function.
+    /// \param function The function to call with each key and value.
+    template <class function_type>
+    void for_each(function_type function) const
+    {
+        if(persistent_map::m_root)
+        {
+            persistent_map::for_each(persistent_map::m_root.get(), function);
+        }
+    }
+
+    // UPDATE
+    /// \brief Creates a new version of the map with a key set to a value.
+    /// \param key The key to insert or replace.
+    /// \param value The value of the key.
+    /// \return The new version of the map.
+    persistent_map<key_type, value_type, hash_type> set(const key_type& key, const value_type& value) const
+    {
+        persistent_map<key_type, value_type, hash_type> result(*this);
+        bool added = true;
+
+        if(persistent_map::m_root)
+        {
+            result.m_root = persistent_map::insert(persistent_map::m_root.get(), 0, hash_type()(key), key, value, added);
+        }
+        else
+        {
+            result.m_root = persistent_map::leaf(0, hash_type()(key), key, value);
+        }
+
+        if(added)
+        {
+            ++result.m_size;
+        }
+        return result;
+    }
+    /// \brief Creates a new version of the map with a key removed.
+    /// \param key The key to remove.
+    /// \return The new version of the map, which shares all nodes with this map if the key was not found.
+    persistent_map<key_type, value_type, hash_type> erase(const key_type& key) const
+    {
+        // Check if the key exists, so that a missing key does not copy any nodes.
+        if(!persistent_map::contains(key))
+        {
+            return *this;
+        }
+
+        persistent_map<key_type, value_type, hash_type> result;
+        result.m_root = persistent_map::remove(persistent_map::m_root.get(), 0, hash_type()(key), key);
+        result.m_size = persistent_map::m_size - 1;
+        return result;
+    }
+
+private:
+    // TYPES
+    /// \brief The type of the trie nodes.
+    typedef persistent_map_node<key_type, value_type> node_type;
+    /// \brief The type of the entries stored in nodes.
+    typedef typename node_type::entry entry_type;
+    /// \brief The number of hash bits consumed per trie level.
+    static const uint8_t bits = 5;
+    /// \brief The number of bits in a hash.
+    static const uint8_t hash_bits = 32;
+
+    // TRIE
+    /// \brief The root node of the trie, or nullptr if the map is empty.
+    shared_ptr<node_type> m_root;
+    /// \brief The number of entries in the map.
+    size_t m_size;
+
+    // BITMAPS
+    /// \brief Gets the bitmap bit for the hash fragment at a level.
+    /// \param hash The hash of the key.
+    /// \param shift The hash shift of the level.
+    /// \return The bitmap bit of the fragment.
+    static uint32_t fragment_bit(uint32_t hash, uint8_t shift)
+    {
+        return static_cast<uint32_t>(1) << ((hash >> shift) & 0x1F);
+    }
+    /// \brief Gets the array slot of a bitmap bit.
+    /// \param map The bitmap.
+    /// \param bit The bit.
+    /// \return The number of set bits below the bit.
+    static uint8_t slot(uint32_t map, uint32_t bit)
+    {
+        return static_cast<uint8_t>(__builtin_popcountl(static_cast<unsigned long>(map & (bit - 1))));
+    }
+
+    // CONSTRUCTION
+    /// \brief Creates a node holding a single entry.
+    /// \param shift The hash shift of the node.
+    /// \param hash The hash of the key.
+    /// \param key The key.
+    /// \param value The value.
+    /// \return The new node.
+    static shared_ptr<node_type> leaf(uint8_t shift, uint32_t hash, const key_type& key, const value_type& value)
+    {
+        shared_ptr<node_type> node = node_type::create(shift >= hash_bits ? 0 : persistent_map::fragment_bit(hash, shift), 0, 1, 0);
+        node->entries()[0].key = key;
+        node->entries()[0].value = value;
+        return node;
+    }
+    /// \brief Creates a node holding two entries with different keys.
+    /// \param shift The hash shift of the node.
+    /// \param first The first entry.
+    /// \param first_hash The hash of the first entry's key.
+    /// \param key The key of the second entry.
+    /// \param value The value of the second entry.
+    /// \param hash The hash of the second entry's key.
+    /// \return The new node.
+    static shared_ptr<node_type> pair(uint8_t shift, const entry_type& first, uint32_t first_hash, const key_type& key, const value_type& value, uint32_t hash)
+    {
+        // Store both entries in a collision node if the hash bits are exhausted.
+        if(shift >= hash_bits)
+        {
+            shared_ptr<node_type> node = node_type::create(0, 0, 2, 0);
+            node->entries()[0] = first;
+            node->entries()[1].key = key;
+            node->entries()[1].value = value;
+            return node;
+        }
+
+        const uint32_t first_bit = persistent_map::fragment_bit(first_hash, shift);
+        const uint32_t bit = persistent_map::fragment_bit(hash, shift);
+
+        // Push both entries down a level if their fragments match.
+        if(first_bit == bit)
+        {
+            shared_ptr<node_type> node = node_type::create(0, bit, 0, 1);
+            node->children()[0] = persistent_map::pair(shift + bits, first, first_hash, key, value, hash);
+            return node;
+        }
+
+        // Otherwise store both entries in fragment order.
+        shared_ptr<node_type> node = node_type::create(first_bit | bit, 0, 2, 0);
+        const uint8_t first_slot = first_bit < bit ? 0 : 1;
+        node->entries()[first_slot] = first;
+        node->entries()[1 - first_slot].key = key;
+        node->entries()[1 - first_slot].value = value;
+        return node;
+    }
+    /// \brief Copies a node with an entry inserted or a child replaced.
+    /// \param node The node to copy.
+    /// \param entry_map The entry bitmap of the copy.
+    /// \param child_map The child bitmap of the copy.
+    /// \param skip_entry The entry slot of the original to leave out, or 0xFF for none.
+    /// \param insert_entry The entry slot of the copy left for the caller to fill, or 0xFF for none.
+    /// \param skip_child The child slot of the original to leave out, or 0xFF for none.
+    /// \param insert_child The child slot of the copy left for the caller to fill, or 0xFF for none.
+    /// \return The copied node.
+    static shared_ptr<node_type> copy(const node_type* node, uint32_t entry_map, uint32_t child_map, uint8_t skip_entry, uint8_t insert_entry, uint8_t skip_child, uint8_t insert_child)
+    {
+        const uint8_t entry_count = node->m_entry_count - (skip_entry != 0xFF) + (insert_entry != 0xFF);
+        const uint8_t child_count = node->m_child_count - (skip_child != 0xFF) + (insert_child != 0xFF);
+        shared_ptr<node_type> result = node_type::create(entry_map, child_map, entry_count, child_count);
+
+        // Copy entries around the skipped and inserted slots.
+        for(uint8_t from = 0, to = 0; from < node->m_entry_count; ++from)
+        {
+            if(from == skip_entry)
+            {
+                continue;
+            }
+            if(to == insert_entry)
+            {
+                ++to;
+            }
+            result->entries()[to++] = node->entries()[from];
+        }
+
+        // Copy children around the skipped and inserted slots.
+        for(uint8_t from = 0, to = 0; from < node->m_child_count; ++from)
+        {
+            if(from == skip_child)
+            {
+                continue;
+            }
+            if(to == insert_child)
+            {
+                ++to;
+            }
+            result->children()[to++] = node->children()[from];
+        }
+
+        return result;
+    }
+
+    // UPDATE
+    /// \brief Copies the path to a key and inserts or replaces its entry.
+    /// \param node The node to copy.
+    /// \param shift The hash shift of the node.
+    /// \param hash The hash of the key.
+    /// \param key The key.
+    /// \param value The value.
+    /// \param added Set to FALSE if an existing entry was replaced.
+    /// \return The copied node.
+    static shared_ptr<node_type> insert(const node_type* node, uint8_t shift, uint32_t hash, const key_type& key, const value_type& value, bool& added)
+    {
+        // Handle collision nodes.
+        if(shift >= hash_bits)
+        {
+            for(uint8_t i = 0; i < node->m_entry_count; ++i)
+            {
+                if(node->entries()[i].key == key)
+                {
+                    shared_ptr<node_type> result = persistent_map::copy(node, 0, 0, 0xFF, 0xFF, 0xFF, 0xFF);
+                    result->entries()[i].value = value;
+                    added = false;
+                    return result;
+                }
+            }
+
+            shared_ptr<node_type> result = persistent_map::copy(node, 0, 0, 0xFF, node->m_entry_count, 0xFF, 0xFF);
+            result->entries()[node->m_entry_count].key = key;
+            result->entries()[node->m_entry_count].value = value;
+            return result;
+        }
+
+        const uint32_t bit = persistent_map::fragment_bit(hash, shift);
+
+        // Check if the fragment holds an entry.
+        if(node->m_entry_map & bit)
+        {
+            const uint8_t entry_slot = persistent_map::slot(node->m_entry_map, bit);
+            const entry_type& existing = node->entries()[entry_slot];
+
+            // Replace the value if the keys match.
+            if(existing.key == key)
+            {
+                shared_ptr<node_type> result = persistent_map::copy(node, node->m_entry_map, node->m_child_map, 0xFF, 0xFF, 0xFF, 0xFF);
+                result->entries()[entry_slot].value = value;
+                added = false;
+                return result;
+            }
+
+            // Otherwise move the existing entry and the new entry into a child node.
+            const uint32_t child_map = node->m_child_map | bit;
+            const uint8_t child_slot = persistent_map::slot(child_map, bit);
+            shared_ptr<node_type> result = persistent_map::copy(node, node->m_entry_map & ~bit, child_map, entry_slot, 0xFF, 0xFF, child_slot);
+            result->children()[child_slot] = persistent_map::pair(shift + bits, existing, hash_type()(existing.key), key, value, hash);
+            return result;
+        }
+
+        // Check if the fragment holds a child node.
+        if(node->m_child_map & bit)
+        {
+            const uint8_t child_slot = persistent_map::slot(node->m_child_map, bit);
+            shared_ptr<node_type> result = persistent_map::copy(node, node->m_entry_map, node->m_child_map, 0xFF, 0xFF, 0xFF, 0xFF);
+            result->children()[child_slot] = persistent_map::insert(node->children()[child_slot].get(), shift + bits, hash, key, value, added);
+            return result;
+        }
+
+        // Otherwise add a new entry.
+        const uint32_t entry_map = node->m_entry_map | bit;
+        const uint8_t entry_slot = persistent_map::slot(entry_map, bit);
+        shared_ptr<node_type> result = persistent_map::copy(node, entry_map, node->m_child_map, 0xFF, entry_slot, 0xFF, 0xFF);
+        result->entries()[entry_slot].key = key;
+        result->entries()[entry_slot].value = value;
+        return result;
+    }
+    /// \brief Copies the path to a key and removes its entry.
+    /// \param node The node to copy, which must contain the key.
+    /// \param shift The hash shift of the node.
+    /// \param hash The hash of the key.
+    /// \param key The key.
+    /// \return The copied node, or nullptr if the node no longer holds any entries.
+    static shared_ptr<node_type> remove(const node_type* node, uint8_t shift, uint32_t hash, const key_type& key)
+    {
+        // Handle collision nodes.
+        if(shift >= hash_bits)
+        {
+            if(node->m_entry_count == 1)
+            {
+                return shared_ptr<node_type>();
+            }
+
+            uint8_t entry_slot = 0;
+            while(!(node->entries()[entry_slot].key == key))
+            {
+                ++entry_slot;
+            }
+            return persistent_map::copy(node, 0, 0, entry_slot, 0xFF, 0xFF, 0xFF);
+        }
+
+        const uint32_t bit = persistent_map::fragment_bit(hash, shift);
+
+        // Remove the entry if it is stored in this node.
+        if(node->m_entry_map & bit)
+        {
+            if(node->m_entry_count == 1 && node->m_child_count == 0)
+            {
+                return shared_ptr<node_type>();
+            }
+            return persistent_map::copy(node, node->m_entry_map & ~bit, node->m_child_map, persistent_map::slot(node->m_entry_map, bit), 0xFF, 0xFF, 0xFF);
+        }
+
+        // Otherwise remove the entry from the child node.
+        const uint8_t child_slot = persistent_map::slot(node->m_child_map, bit);
+        shared_ptr<node_type> child = persistent_map::remove(node->children()[child_slot].get(), shift + bits, hash, key);
+
+        // Drop the child node if it is now empty.
+        if(!child)
+        {
+            if(node->m_entry_count == 0 && node->m_child_count == 1)
+            {
+                return shared_ptr<node_type>();
+            }
+            return persistent_map::copy(node, node->m_entry_map, node->m_child_map & ~bit, 0xFF, 0xFF, child_slot, 0xFF);
+        }
+
+        // Pull the child's last entry up into this node so that lookups stay short.
+        if(child->m_entry_count == 1 && child->m_child_count == 0)
+        {
+            const uint32_t entry_map = node->m_entry_map | bit;
+            const uint8_t entry_slot = persistent_map::slot(entry_map, bit);
+            shared_ptr<node_type> result = persistent_map::copy(node, entry_map, node->m_child_map & ~bit, 0xFF, entry_slot, child_slot, 0xFF);
+            result->entries()[entry_slot] = child->entries()[0];
+            return result;
+        }
+
+        // Otherwise replace the child node.
+        shared_ptr<node_type> result = persistent_map::copy(node, node->m_entry_map, node->m_child_map, 0xFF, 0xFF, 0xFF, 0xFF);
+        result->children()[child_slot] = child;
+        return result;
+    }
+
+    // ITERATION
+    /// \brief Calls a function for each entry in a subtree.
+    /// \tparam function_type The type of the function.
+    /// \param node The root of the subtree.
+    /// \param function The function to call with each key and value.
+    template <class function_type>
+    static void for_each(const node_type* node, function_type& function)
+    {
+        for(uint8_t i = 0; i < node->m_entry_count; ++i)
+        {
+            function(node->entries()[i].key, node->entries()[i].value);
+        }
+        for(uint8_t i = 0; i < node->m_child_count; ++i)
+        {
+            persistent_map::for_each(node->children()[i].get(), function);
+        }
+    }
+};
+
+#endif
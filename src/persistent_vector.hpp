@@ -0,0 +1,341 @@
+/// \file persistent_vector.hpp
+/// \brief Defines the persistent_vector class.
+#ifndef SMART_PTR___PERSISTENT_VECTOR_H
+#define SMART_PTR___PERSISTENT_VECTOR_H
+
+#include <shared_ptr.hpp>
+#include <trailing.hpp>
+
+#include <new>
+#include <stdint.h>
+
+/// \brief A node of a persistent_vector trie.
+/// \details Branch nodes hold child nodes, leaf nodes hold values. Nodes are never modified once shared. The slots
+/// are stored directly after the node, and the counts, node, and slots share one allocation, so create nodes with
+/// create() rather than constructing them directly.
+/// \tparam value_type The type of the stored values.
+/// \tparam width The number of slots in each node.
+template <class value_type, size_t width>
+class alignas(value_type) alignas(shared_ptr<value_type>) persistent_vector_node
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Creates a new node with value-initialized slots.
+    /// \param leaf Indicates if the node stores values instead of child nodes.
+    persistent_vector_node(bool leaf)
+        : m_leaf(leaf)
+    {
+        for(size_t i = 0; i < width; ++i)
+        {
+            if(persistent_vector_node::m_leaf)
+            {
+                new (persistent_vector_node::values() + i) value_type();
+            }
+            else
+            {
+                new (persistent_vector_node::children() + i) shared_ptr<persistent_vector_node>();
+            }
+        }
+    }
+    /// \brief Copy constructs from another node.
+    /// \param other The node to copy.
+    persistent_vector_node(const persistent_vector_node<value_type, width>& other)
+        : m_leaf(other.m_leaf)
+    {
+        // Copy slots. Child nodes are shared, not copied.
+        for(size_t i = 0; i < width; ++i)
+        {
+            if(persistent_vector_node::m_leaf)
+            {
+                new (persistent_vector_node::values() + i) value_type(other.values()[i]);
+            }
+            else
+            {
+                new (persistent_vector_node::children() + i) shared_ptr<persistent_vector_node>(other.children()[i]);
+            }
+        }
+    }
+    persistent_vector_node<value_type, width>& operator=(const persistent_vector_node<value_type, width>& other) = delete;
+    ~persistent_vector_node()
+    {
+        // Destroy slots in reverse order of construction.
+        for(size_t i = width; i > 0; --i)
+        {
+            if(persistent_vector_node::m_leaf)
+            {
+                persistent_vector_node::values()[i - 1].~value_type();
+            }
+            else
+            {
+                persistent_vector_node::children()[i - 1].~shared_ptr<persistent_vector_node>();
+            }
+        }
+    }
+
+    // CREATION
+    /// \brief Creates a new node with value-initialized slots in a single allocation.
+    /// \param leaf Indicates if the node stores values instead of child nodes.
+    /// \return A shared_ptr to the new node.
+    static shared_ptr<persistent_vector_node> create(bool leaf)
+    {
+        return make_shared_trailing<persistent_vector_node>(persistent_vector_node::slot_bytes(leaf), leaf);
+    }
+    /// \brief Creates a copy of a node in a single allocation.
+    /// \param other The node to copy.
+    /// \return A shared_ptr to the new node.
+    static shared_ptr<persistent_vector_node> create(const persistent_vector_node<value_type, width>& other)
+    {
+        return make_shared_trailing<persistent_vector_node>(persistent_vector_node::slot_bytes(other.m_leaf), other);
+    }
+
+    // SLOTS
+    /// \brief Gets the child nodes of a branch node.
+    /// \return A pointer to the first child node.
+    shared_ptr<persistent_vector_node>* children()
+    {
+        return reinterpret_cast<shared_ptr<persistent_vector_node>*>(this + 1);
+    }
+    /// \brief Gets the child nodes of a branch node.
+    /// \return A pointer to the first child node.
+    const shared_ptr<persistent_vector_node>* children() const
+    {
+        return reinterpret_cast<const shared_ptr<persistent_vector_node>*>(this + 1);
+    }
+    /// \brief Gets the values of a leaf node.
+    /// \return A pointer to the first value.
+    value_type* values()
+    {
+        return reinterpret_cast<value_type*>(this + 1);
+    }
+    /// \brief Gets the values of a leaf node.
+    /// \return A pointer to the first value.
+    const value_type* values() const
+    {
+        return reinterpret_cast<const value_type*>(this + 1);
+    }
+
+private:
+    // SLOTS
+    /// \brief Indicates if the node stores values instead of child nodes.
+    bool m_leaf;
+
+    /// \brief Gets the size of the slots stored after a node.
+    /// \param leaf Indicates if the node stores values instead of child nodes.
+    /// \return The size of the slots in bytes.
+    static size_t slot_bytes(bool leaf)
+    {
+        return width * (leaf ? sizeof(value_type) : sizeof(shared_ptr<persistent_vector_node>));
+    }
+};
+
+/// \brief An immutable vector that shares structure between versions.
+/// \details Values are stored in a radix trie of shared_ptr nodes. Copying a persistent_vector is O(1), and
+/// each update copies only the O(log n) nodes on the path to the changed value.
+/// \tparam value_type The type of the stored values. Must be default constructible and copy assignable.
+/// \tparam bits The number of index bits consumed per trie level. Each node has 2^bits slots.
+template <class value_type, uint8_t bits = 4>
+class persistent_vector
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Creates a new, empty persistent_vector instance.
+    persistent_vector()
+        : m_size(0),
+          m_shift(0)
+    {}
+
+    // ACCESS
+    /// \brief Gets the number of values in the vector.
+    /// \return The number of values.
+    size_t size() const
+    {
+        return persistent_vector::m_size;
+    }
+    /// \brief Indicates if the vector contains no values.
+    /// \return TRUE if the vector is empty, otherwise FALSE.
+    bool empty() const
+    {
+        return persistent_vector::m_size == 0;
+    }
+    /// \brief Gets a value by index.
+    /// \param index The index of the value. Must be less than size().
+    /// \return A reference to the value.
+    const value_type& operator[](size_t index) const
+    {
+        // Walk down the trie to the leaf.
+        const node_type* current = persistent_vector::m_root.get();
+        for(uint8_t shift = persistent_vector::m_shift; shift > 0; shift -= bits)
+        {
+            current = current->children()[(index >> shift) & mask].get();
+        }
+
+        return current->values()[index & mask];
+    }
+    /// \brief Calls a function for each value, in index order.
+    /// \tparam function_type The type of the function.
+    /// \param function The function to call with each value.
+    template <class function_type>
+    void for_each(function_type function) const
+    {
+        if(persistent_vector::m_root)
+        {
+            persistent_vector::for_each(persistent_vector::m_root.get(), persistent_vector::m_shift, persistent_vector::m_size, function);
+        }
+    }
+
+    // UPDATE
+    /// \brief Creates a new version of the vector with a value replaced.
+    /// \param index The index of the value to replace. Must be less than size().
+    /// \param value The new value.
+    /// \return The new version of the vector.
+    persistent_vector<value_type, bits> set(size_t index, const value_type& value) const
+    {
+        persistent_vector<value_type, bits> result(*this);
+        result.m_root = persistent_vector::assign(persistent_vector::m_root.get(), persistent_vector::m_shift, index, value);
+        return result;
+    }
+    /// \brief Creates a new version of the vector with a value appended.
+    /// \param value The value to append.
+    /// \return The new version of the vector.
+    persistent_vector<value_type, bits> push_back(const value_type& value) const
+    {
+        persistent_vector<value_type, bits> result(*this);
+
+        // Add a new root level if the trie is full.
+        if(persistent_vector::m_root && persistent_vector::m_size == (static_cast<size_t>(1) << (persistent_vector::m_shift + bits)))
+        {
+            shared_ptr<node_type> root = node_type::create(false);
+            root->children()[0] = persistent_vector::m_root;
+            result.m_root = root;
+            result.m_shift += bits;
+        }
+
+        result.m_root = persistent_vector::assign(result.m_root.get(), result.m_shift, persistent_vector::m_size, value);
+        ++result.m_size;
+        return result;
+    }
+    /// \brief Creates a new version of the vector with the last value removed.
+    /// \details The vector must not be empty.
+    /// \return The new version of the vector.
+    persistent_vector<value_type, bits> pop_back() const
+    {
+        persistent_vector<value_type, bits> result;
+
+        // Check if the last value is being removed.
+        if(persistent_vector::m_size == 1)
+        {
+            return result;
+        }
+
+        result.m_size = persistent_vector::m_size - 1;
+        result.m_shift = persistent_vector::m_shift;
+        result.m_root = persistent_vector::remove(persistent_vector::m_root.get(), persistent_vector::m_shift, result.m_size);
+
+        // Remove the root level if all remaining values fit in its first child.
+        if(result.m_shift > 0 && result.m_size <= (static_cast<size_t>(1) << result.m_shift))
+        {
+            shared_ptr<node_type> root = result.m_root->children()[0];
+            result.m_root = root;
+            result.m_shift -= bits;
+        }
+
+        return result;
+    }
+
+private:
+    // TYPES
+    /// \brief The type of the trie nodes.
+    typedef persistent_vector_node<value_type, static_cast<size_t>(1) << bits> node_type;
+    /// \brief The mask for selecting a slot within a node.
+    static const size_t mask = (static_cast<size_t>(1) << bits) - 1;
+
+    // TRIE
+    /// \brief The root node of the trie, or nullptr if the vector is empty.
+    shared_ptr<node_type> m_root;
+    /// \brief The number of values in the vector.
+    size_t m_size;
+    /// \brief The index shift of the root node. Zero if the root is a leaf.
+    uint8_t m_shift;
+
+    // UPDATE
+    /// \brief Copies the path to an index and stores a value at the end of it.
+    /// \param node The node to copy, or nullptr to create a new node.
+    /// \param shift The index shift of the node.
+    /// \param index The index of the value.
+    /// \param value The value to store.
+    /// \return The copied node.
+    static shared_ptr<node_type> assign(const node_type* node, uint8_t shift, size_t index, const value_type& value)
+    {
+        shared_ptr<node_type> copy = node ? node_type::create(*node) : node_type::create(shift == 0);
+
+        if(shift == 0)
+        {
+            copy->values()[index & mask] = value;
+        }
+        else
+        {
+            shared_ptr<node_type>& child = copy->children()[(index >> shift) & mask];
+            child = persistent_vector::assign(child.get(), shift - bits, index, value);
+        }
+
+        return copy;
+    }
+    /// \brief Copies the path to an index and clears the value at the end of it.
+    /// \param node The node to copy.
+    /// \param shift The index shift of the node.
+    /// \param index The index of the value, which must be the last value in the vector.
+    /// \return The copied node, or nullptr if the node no longer holds any values.
+    static shared_ptr<node_type> remove(const node_type* node, uint8_t shift, size_t index)
+    {
+        // Check if the value is the only one in this subtree.
+        if((index & ((static_cast<size_t>(1) << (shift + bits)) - 1)) == 0)
+        {
+            return shared_ptr<node_type>();
+        }
+
+        shared_ptr<node_type> copy = node_type::create(*node);
+
+        if(shift == 0)
+        {
+            copy->values()[index & mask] = value_type();
+        }
+        else
+        {
+            shared_ptr<node_type>& child = copy->children()[(index >> shift) & mask];
+            child = persistent_vector::remove(child.get(), shift - bits, index);
+        }
+
+        return copy;
+    }
+
+    // ITERATION
+    /// \brief Calls a function for each value in a subtree, in index order.
+    /// \tparam function_type The type of the function.
+    /// \param node The root of the subtree.
+    /// \param shift The index shift of the node.
+    /// \param count The number of values in the subtree.
+    /// \param function The function to call with each value.
+    template <class function_type>
+    static void for_each(const node_type* node, uint8_t shift, size_t count, function_type& function)
+    {
+        if(shift == 0)
+        {
+            for(size_t i = 0; i < count; ++i)
+            {
+                function(node->values()[i]);
+            }
+        }
+        else
+        {
+            const size_t child_capacity = static_cast<size_t>(1) << shift;
+            for(size_t i = 0; count > 0; ++i)
+            {
+                const size_t child_count = count < child_capacity ? count : child_capacity;
+                persistent_vector::for_each(node->children()[i].get(), shift - bits, child_count, function);
+                count -= child_count;
+            }
+        }
+    }
+};
+
+#endif
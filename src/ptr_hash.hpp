@@ -0,0 +1,75 @@
+/// \file ptr_hash.hpp
+/// \brief Defines the hash function for pointer keys.
+#ifndef SMART_PTR___PTR_HASH_H
+#define SMART_PTR___PTR_HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// \brief Gets the address a pointer key refers to.
+/// \details Supports raw pointers and any smart pointer with a get() member. Specialize for other key types.
+/// \tparam pointer_type The type of the key.
+template <class pointer_type>
+struct ptr_key
+{
+    /// \brief Gets the address of a key.
+    /// \param key The key.
+    /// \return The address of the object the key points to, or nullptr if the key is empty.
+    static const void* address(const pointer_type& key)
+    {
+        return key.get();
+    }
+};
+/// \brief Gets the address a raw pointer key refers to.
+/// \tparam object_type The type the pointer key points to.
+template <class object_type>
+struct ptr_key<object_type*>
+{
+    /// \brief Gets the address of a key.
+    /// \param key The key.
+    /// \return The key.
+    static const void* address(object_type* key)
+    {
+        return key;
+    }
+};
+
+/// \brief The hash function for pointer keys.
+/// \details Hashes the address a key refers to, so a smart pointer and a raw pointer to the same object hash
+/// equally. The low bits of an address are zero because of alignment and the high bits rarely change, so the
+/// address is mixed until every bit affects the low bits that tables index with.
+struct ptr_hash
+{
+    /// \brief Hashes a key.
+    /// \tparam pointer_type The type of the key.
+    /// \param key The key to hash.
+    /// \return The hash of the key's address.
+    template <class pointer_type>
+    size_t operator()(const pointer_type& key) const
+    {
+        return ptr_hash::mix(ptr_key<pointer_type>::address(key));
+    }
+    /// \brief Mixes the bits of an address.
+    /// \param address The address to mix.
+    /// \return The mixed address.
+    static size_t mix(const void* address)
+    {
+        uintptr_t value = reinterpret_cast<uintptr_t>(address);
+#if UINTPTR_MAX > 0xFFFFFFFFUL
+        value ^= value >> 33;
+        value *= 0xFF51AFD7ED558CCDULL;
+        value ^= value >> 33;
+        return static_cast<size_t>(value);
+#else
+        uint32_t mixed = static_cast<uint32_t>(value);
+        mixed ^= mixed >> 16;
+        mixed *= 0x85EBCA6BUL;
+        mixed ^= mixed >> 13;
+        mixed *= 0xC2B2AE35UL;
+        mixed ^= mixed >> 16;
+        return static_cast<size_t>(mixed);
+#endif
+    }
+};
+
+#endif
@@ -0,0 +1,143 @@
+/// \file shared_borrow.hpp
+/// \brief Defines the shared_borrow class.
+#ifndef SMART_PTR___SHARED_BORROW_H
+#define SMART_PTR___SHARED_BORROW_H
+
+#include <shared_ptr.hpp>
+
+/// \brief A non-owning view of an object owned by shared_ptrs, for passing the object without reference counting.
+/// \details Creating, copying, and destroying a shared_borrow never touches the use count, and a shared_borrow is
+/// trivially copyable so it can be passed in registers. The object must stay owned by at least one shared_ptr for
+/// as long as any shared_borrow of it exists; when SMART_PTR_CHECKED is defined, releasing the last owner while
+/// borrows remain traps. promote() creates a new owning shared_ptr when the callee needs to retain the object.
+/// \tparam object_type The type of the object.
+template <class object_type>
+class shared_borrow
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Creates a new, empty shared_borrow instance.
+    shared_borrow()
+        : m_object(nullptr),
+          m_count(nullptr)
+    {}
+    /// \brief Creates a new shared_borrow instance viewing the object of a shared_ptr.
+    /// \param owner The shared_ptr that owns the object for the lifetime of the borrow.
+    shared_borrow(const shared_ptr<object_type>& owner)
+        : m_object(owner.m_object),
+          m_count(owner.m_count)
+    {
+        // Register the borrow with the checked counts.
+        shared_borrow::increment_borrow_count();
+    }
+#ifdef SMART_PTR_CHECKED
+    /// \brief Copy constructs from another shared borrow instance.
+    /// \param other The shared_borrow instance to copy.
+    shared_borrow(const shared_borrow<object_type>& other)
+        : m_object(other.m_object),
+          m_count(other.m_count)
+    {
+        // Register the borrow with the checked counts.
+        shared_borrow::increment_borrow_count();
+    }
+    /// \brief Copy assigns this shared_borrow from another shared_borrow.
+    /// \param other The shared_borrow instance to copy.
+    /// \return A reference to this shared_borrow.
+    shared_borrow<object_type>& operator=(const shared_borrow<object_type>& other)
+    {
+        // Move the registration to the new counts.
+        if(other.m_count)
+        {
+            other.m_count->increment_borrow_count();
+        }
+        shared_borrow::decrement_borrow_count();
+
+        // Copy object and counts.
+        shared_borrow::m_object = other.m_object;
+        shared_borrow::m_count = other.m_count;
+
+        return *this;
+    }
+    ~shared_borrow()
+    {
+        // Unregister the borrow from the checked counts.
+        shared_borrow::decrement_borrow_count();
+    }
+#endif
+
+    // ACCESS
+    /// \brief Gets the pointer to the borrowed object instance.
+    /// \return A pointer to the object instance.
+    object_type* get() const
+    {
+        return shared_borrow::m_object;
+    }
+    /// \brief Dereferences the pointer to the borrowed object instance.
+    /// \return A pointer to the object instance.
+    object_type* operator->() const
+    {
+        SMART_PTR_CHECK(shared_borrow::m_object);
+        return shared_borrow::m_object;
+    }
+    /// \brief Dereferences the pointer to the borrowed object instance.
+    /// \return A reference to the object instance.
+    object_type& operator*() const
+    {
+        SMART_PTR_CHECK(shared_borrow::m_object);
+        return *shared_borrow::m_object;
+    }
+    /// \brief Checks if this shared_borrow references an object instance.
+    /// \return TRUE if this shared_borrow references an object instance, false if it is nullptr.
+    operator bool() const
+    {
+        return shared_borrow::m_object != nullptr;
+    }
+
+    // PROMOTION
+    /// \brief Creates a shared_ptr that shares ownership of the borrowed object.
+    /// \return A shared_ptr managing the object, or an empty shared_ptr if this shared_borrow is empty.
+    shared_ptr<object_type> promote() const
+    {
+        // Check if there is a borrowed object.
+        if(shared_borrow::m_count)
+        {
+            shared_borrow::m_count->increment_use_count();
+            return shared_ptr<object_type>(shared_borrow::m_object, shared_borrow::m_count);
+        }
+        else
+        {
+            return shared_ptr<object_type>();
+        }
+    }
+
+private:
+    // OBJECT
+    /// \brief A pointer to the borrowed object instance.
+    object_type* m_object;
+    /// \brief A pointer to the reference counts of the object instance, used for promotion.
+    shared_count* m_count;
+
+    // BORROW COUNT
+    /// \brief Registers this borrow with the checked counts. Does nothing unless SMART_PTR_CHECKED is defined.
+    void increment_borrow_count()
+    {
+#ifdef SMART_PTR_CHECKED
+        if(shared_borrow::m_count)
+        {
+            shared_borrow::m_count->increment_borrow_count();
+        }
+#endif
+    }
+    /// \brief Unregisters this borrow from the checked counts. Does nothing unless SMART_PTR_CHECKED is defined.
+    void decrement_borrow_count()
+    {
+#ifdef SMART_PTR_CHECKED
+        if(shared_borrow::m_count)
+        {
+            shared_borrow::m_count->decrement_borrow_count();
+        }
+#endif
+    }
+};
+
+#endif
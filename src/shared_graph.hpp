@@ -0,0 +1,692 @@
+/// \file shared_graph.hpp
+/// \brief Defines the shared_graph_writer and shared_graph_reader classes, which serialize graphs of shared_ptrs.
+#ifndef SMART_PTR___SHARED_GRAPH_H
+#define SMART_PTR___SHARED_GRAPH_H
+
+#include <shared_ptr.hpp>
+
+#include <new>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef ARDUINO
+#include <stdio.h>
+#endif
+
+class shared_graph_writer;
+class shared_graph_reader;
+
+/// \brief Writes and reads the contents of an object in a shared_ptr graph.
+/// \details Specialize this for every type in a graph, with static functions write(const object_type&,
+/// shared_graph_writer&) and read(object_type&, shared_graph_reader&) that write and read the same fields in the
+/// same order. shared_ptr members are written and read with the writer's and reader's write() and read(); the
+/// objects they reference are written later, so neither function recurses into other objects. Objects are
+/// default constructed before read() fills them in.
+/// \tparam object_type The type of the object.
+template <class object_type>
+struct shared_graph_traits;
+
+/// \brief Writes a graph of objects linked by shared_ptrs as a binary stream.
+/// \details Every object is written once, however many shared_ptrs reference it, and cycles are written without
+/// looping. Objects are identified by their control block and address, so the objects of a shared_group stay
+/// distinct, and are numbered in the order they are first referenced. The stream is "SPG1", the reference to the
+/// root, then the contents of each object in the order of their numbers. References are unsigned LEB128 varints
+/// holding 0 for nullptr or the number of the object.
+class shared_graph_writer
+{
+public:
+    // TYPES
+    /// \brief The type of a function that writes stream data, for example to a file or a serial port.
+    typedef void (*writer_type)(const uint8_t* data, size_t size, void* context);
+
+    // CONSTRUCTORS
+    /// \brief Creates a new shared_graph_writer instance.
+    /// \param writer The function that writes the stream.
+    /// \param context The context passed to the writer.
+    shared_graph_writer(writer_type writer, void* context)
+        : m_writer(writer),
+          m_context(context),
+          m_objects(nullptr),
+          m_object_count(0),
+          m_object_capacity(0),
+          m_table(nullptr),
+          m_table_capacity(0)
+    {}
+#ifndef ARDUINO
+    /// \brief Creates a new shared_graph_writer instance that writes to a file.
+    /// \param file The file to write to.
+    shared_graph_writer(FILE* file)
+        : shared_graph_writer(&shared_graph_writer::write_file, file)
+    {}
+#endif
+    shared_graph_writer(const shared_graph_writer& other) = delete;
+    shared_graph_writer& operator=(const shared_graph_writer& other) = delete;
+    ~shared_graph_writer()
+    {
+        delete[] shared_graph_writer::m_objects;
+        delete[] shared_graph_writer::m_table;
+    }
+
+    // GRAPH
+    /// \brief Writes the graph reachable from a root.
+    /// \tparam object_type The type of the root object.
+    /// \param root The root of the graph.
+    template <class object_type>
+    void write_graph(const shared_ptr<object_type>& root)
+    {
+        shared_graph_writer::write_bytes("SPG1", 4);
+        shared_graph_writer::write(root);
+
+        // Write the contents of each object, which may number further objects.
+        for(size_t i = 0; i < shared_graph_writer::m_object_count; ++i)
+        {
+            shared_graph_writer::m_objects[i].write(shared_graph_writer::m_objects[i].object, *this);
+        }
+    }
+
+    // FIELDS
+    /// \brief Writes a reference to an object, numbering the object if it has not been referenced before.
+    /// \tparam object_type The type of the object.
+    /// \param reference The reference.
+    template <class object_type>
+    void write(const shared_ptr<object_type>& reference)
+    {
+        if(!reference.m_object)
+        {
+            shared_graph_writer::write_unsigned(0);
+            return;
+        }
+
+        // Number the object if it is new.
+        size_t slot = shared_graph_writer::find(reference.m_count, reference.m_object);
+        if(!shared_graph_writer::m_table[slot].number)
+        {
+            shared_graph_writer::add(slot, reference.m_count, reference.m_object, &shared_graph_writer::write_object<object_type>);
+        }
+        shared_graph_writer::write_unsigned(shared_graph_writer::m_table[slot].number);
+    }
+    /// \brief Writes an unsigned integer as a LEB128 varint.
+    /// \param value The value.
+    void write_unsigned(uint64_t value)
+    {
+        uint8_t encoded[10];
+        uint8_t size = 0;
+        while(value >= 0x80)
+        {
+            encoded[size++] = static_cast<uint8_t>(value) | 0x80;
+            value >>= 7;
+        }
+        encoded[size++] = static_cast<uint8_t>(value);
+        shared_graph_writer::write_bytes(encoded, size);
+    }
+    /// \brief Writes a signed integer as a zigzag encoded LEB128 varint.
+    /// \param value The value.
+    void write_signed(int64_t value)
+    {
+        shared_graph_writer::write_unsigned((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+    }
+    /// \brief Writes the bytes of a trivially copyable value in the byte order of the machine.
+    /// \tparam value_type The type of the value.
+    /// \param value The value.
+    template <class value_type>
+    void write_value(const value_type& value)
+    {
+        shared_graph_writer::write_bytes(&value, sizeof(value_type));
+    }
+    /// \brief Writes raw bytes.
+    /// \param data The bytes.
+    /// \param size The number of bytes.
+    void write_bytes(const void* data, size_t size)
+    {
+        shared_graph_writer::m_writer(static_cast<const uint8_t*>(data), size, shared_graph_writer::m_context);
+    }
+
+private:
+    // OUTPUT
+    /// \brief The function that writes the stream.
+    writer_type m_writer;
+    /// \brief The context passed to the writer.
+    void* m_context;
+
+    // OBJECTS
+    /// \brief A numbered object.
+    struct object_entry
+    {
+        /// \brief The object.
+        const void* object;
+        /// \brief Writes the contents of the object.
+        void (*write)(const void* object, shared_graph_writer& writer);
+    };
+    /// \brief The numbered objects, in the order of their numbers.
+    object_entry* m_objects;
+    /// \brief The number of numbered objects.
+    size_t m_object_count;
+    /// \brief The capacity of m_objects.
+    size_t m_object_capacity;
+
+    // TABLE
+    /// \brief A slot of the table that finds the numbers of objects.
+    struct table_slot
+    {
+        /// \brief The control block of the object.
+        const shared_count* count;
+        /// \brief The object.
+        const void* object;
+        /// \brief The number of the object, or 0 if the slot is empty.
+        size_t number;
+    };
+    /// \brief The open addressing table that finds the numbers of objects.
+    table_slot* m_table;
+    /// \brief The capacity of m_table, a power of two.
+    size_t m_table_capacity;
+
+    /// \brief Finds the slot of an object, growing the table if it is half full.
+    /// \param count The control block of the object.
+    /// \param object The object.
+    /// \return The index of the slot holding the object, or of the empty slot where it belongs.
+    size_t find(const shared_count* count, const void* object)
+    {
+        if(2 * (shared_graph_writer::m_object_count + 1) > shared_graph_writer::m_table_capacity)
+        {
+            shared_graph_writer::grow_table();
+        }
+
+        size_t mask = shared_graph_writer::m_table_capacity - 1;
+        size_t slot = shared_graph_writer::hash(count, object) & mask;
+        while(shared_graph_writer::m_table[slot].number &&
+              (shared_graph_writer::m_table[slot].count != count || shared_graph_writer::m_table[slot].object != object))
+        {
+            slot = (slot + 1) & mask;
+        }
+        return slot;
+    }
+    /// \brief Numbers a new object.
+    /// \param slot The empty slot where the object belongs.
+    /// \param count The control block of the object.
+    /// \param object The object.
+    /// \param write The function that writes the contents of the object.
+    void add(size_t slot, const shared_count* count, const void* object, void (*write)(const void* object, shared_graph_writer& writer))
+    {
+        // Grow the object list if it is full.
+        if(shared_graph_writer::m_object_count == shared_graph_writer::m_object_capacity)
+        {
+            size_t capacity = shared_graph_writer::m_object_capacity ? 2 * shared_graph_writer::m_object_capacity : 16;
+            object_entry* objects = new object_entry[capacity];
+            if(shared_graph_writer::m_object_count)
+            {
+                memcpy(objects, shared_graph_writer::m_objects, shared_graph_writer::m_object_count * sizeof(object_entry));
+            }
+            delete[] shared_graph_writer::m_objects;
+            shared_graph_writer::m_objects = objects;
+            shared_graph_writer::m_object_capacity = capacity;
+        }
+
+        shared_graph_writer::m_objects[shared_graph_writer::m_object_count++] = {object, write};
+        shared_graph_writer::m_table[slot] = {count, object, shared_graph_writer::m_object_count};
+    }
+    /// \brief Doubles the capacity of the table.
+    void grow_table()
+    {
+        size_t capacity = shared_graph_writer::m_table_capacity ? 2 * shared_graph_writer::m_table_capacity : 32;
+        table_slot* table = new table_slot[capacity]();
+        for(size_t i = 0; i < shared_graph_writer::m_table_capacity; ++i)
+        {
+            const table_slot& moved = shared_graph_writer::m_table[i];
+            if(moved.number)
+            {
+                size_t slot = shared_graph_writer::hash(moved.count, moved.object) & (capacity - 1);
+                while(table[slot].number)
+                {
+                    slot = (slot + 1) & (capacity - 1);
+                }
+                table[slot] = moved;
+            }
+        }
+        delete[] shared_graph_writer::m_table;
+        shared_graph_writer::m_table = table;
+        shared_graph_writer::m_table_capacity = capacity;
+    }
+    /// \brief Hashes the identity of an object.
+    /// \param count The control block of the object.
+    /// \param object The object.
+    /// \return The hash.
+    static size_t hash(const shared_count* count, const void* object)
+    {
+        uintptr_t value = reinterpret_cast<uintptr_t>(count) ^ (reinterpret_cast<uintptr_t>(object) >> 3);
+        value ^= value >> 7;
+        value *= static_cast<uintptr_t>(0x9E3779B97F4A7C15ull);
+        return static_cast<size_t>(value ^ (value >> 15));
+    }
+    /// \brief Writes the contents of an object through its traits.
+    /// \tparam object_type The type of the object.
+    /// \param object The object.
+    /// \param writer The writer.
+    template <class object_type>
+    static void write_object(const void* object, shared_graph_writer& writer)
+    {
+        shared_graph_traits<object_type>::write(*static_cast<const object_type*>(object), writer);
+    }
+
+#ifndef ARDUINO
+    /// \brief Writes stream data to a file.
+    /// \param data The data to write.
+    /// \param size The number of bytes to write.
+    /// \param context The FILE to write to.
+    static void write_file(const uint8_t* data, size_t size, void* context)
+    {
+        fwrite(data, 1, size, static_cast<FILE*>(context));
+    }
+#endif
+};
+
+/// \brief The header of an arena chunk of a shared_graph_reader, followed by the blocks of restored objects.
+struct shared_graph_chunk
+{
+    /// \brief The number of live blocks in the chunk, plus one while the reader still allocates from it.
+    size_t live;
+    /// \brief The size of the chunk in bytes, including this header.
+    size_t size;
+
+    // ALLOCATION
+    /// \brief Allocates a chunk and reports it to the instrumentation tools.
+    /// \param size The size of the chunk in bytes, including the header.
+    /// \return The new chunk, held by the reader.
+    static shared_graph_chunk* allocate(size_t size)
+    {
+        void* memory = ::operator new(size);
+        smart_ptr_hooks::allocate<shared_graph_chunk>(memory, size);
+
+        shared_graph_chunk* chunk = static_cast<shared_graph_chunk*>(memory);
+        chunk->live = 1;
+        chunk->size = size;
+        return chunk;
+    }
+    /// \brief Drops one hold on a chunk, freeing it with the last one.
+    /// \param chunk The chunk.
+    static void release(shared_graph_chunk* chunk)
+    {
+        if(--chunk->live == 0)
+        {
+            smart_ptr_hooks::free<shared_graph_chunk>(chunk, chunk->size);
+            ::operator delete(chunk);
+        }
+    }
+};
+
+/// \brief The control block and storage of an object restored into a shared_graph_reader's arena.
+/// \details Each object keeps its own counts, so it is destroyed as soon as it is released, while the arena chunk
+/// holding it is freed once all of the chunk's objects have been freed.
+/// \tparam object_type The type of the object.
+template <class object_type>
+class shared_graph_block
+    : public shared_count
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Creates a new shared_graph_block instance with a default constructed object.
+    /// \param chunk The arena chunk holding the block.
+    shared_graph_block(shared_graph_chunk* chunk)
+        : shared_count(&shared_graph_block::manage),
+          object(),
+          m_chunk(chunk)
+    {}
+    /// \brief Destroys the block. The object is destroyed earlier, when its last shared_ptr is released.
+    ~shared_graph_block()
+    {}
+
+    union
+    {
+        /// \brief The object.
+        object_type object;
+    };
+
+private:
+    // ARENA
+    /// \brief The arena chunk holding the block.
+    shared_graph_chunk* m_chunk;
+
+    // MANAGER
+    /// \brief Destroys the object or frees the block.
+    /// \param count The counts of the block.
+    /// \param action The operation to perform.
+    static void manage(shared_count* count, shared_count::operation action)
+    {
+        shared_graph_block<object_type>* block = static_cast<shared_graph_block<object_type>*>(count);
+
+        if(action == shared_count::operation::destroy)
+        {
+            block->object.~object_type();
+        }
+        else
+        {
+            // Free the chunk with its last block.
+            shared_graph_chunk* chunk = block->m_chunk;
+            block->~shared_graph_block();
+            shared_graph_chunk::release(chunk);
+        }
+    }
+};
+
+/// \brief Reads a graph written by shared_graph_writer, restoring the same sharing and cycles.
+/// \details Every object is default constructed when it is first referenced and filled in by
+/// shared_graph_traits::read() later in the stream. Objects are allocated individually, or packed into arena chunks
+/// for locality and fast allocation.
+class shared_graph_reader
+{
+public:
+    // TYPES
+    /// \brief The type of a function that reads stream data, for example from a file or a serial port.
+    /// \return The number of bytes read, which is less than size only at the end of the stream or on error.
+    typedef size_t (*reader_type)(uint8_t* data, size_t size, void* context);
+
+    // CONSTRUCTORS
+    /// \brief Creates a new shared_graph_reader instance.
+    /// \param reader The function that reads the stream.
+    /// \param context The context passed to the reader.
+    /// \param arena_chunk The size of the arena chunks in bytes that objects are packed into, or 0 to allocate each
+    /// object separately.
+    shared_graph_reader(reader_type reader, void* context, size_t arena_chunk = 0)
+        : m_reader(reader),
+          m_context(context),
+          m_failed(false),
+          m_objects(nullptr),
+          m_object_count(0),
+          m_object_capacity(0),
+          m_arena_chunk(arena_chunk),
+          m_chunk(nullptr),
+          m_chunk_used(0)
+    {}
+#ifndef ARDUINO
+    /// \brief Creates a new shared_graph_reader instance that reads from a file.
+    /// \param file The file to read from.
+    /// \param arena_chunk The size of the arena chunks in bytes that objects are packed into, or 0 to allocate each
+    /// object separately.
+    shared_graph_reader(FILE* file, size_t arena_chunk = 0)
+        : shared_graph_reader(&shared_graph_reader::read_file, file, arena_chunk)
+    {}
+#endif
+    shared_graph_reader(const shared_graph_reader& other) = delete;
+    shared_graph_reader& operator=(const shared_graph_reader& other) = delete;
+    ~shared_graph_reader()
+    {
+        shared_graph_reader::release();
+    }
+
+    // GRAPH
+    /// \brief Reads a graph.
+    /// \tparam object_type The type of the root object.
+    /// \param root The root of the graph, set to nullptr if the stream is invalid.
+    /// \return TRUE if the graph was read, otherwise FALSE.
+    template <class object_type>
+    bool read_graph(shared_ptr<object_type>& root)
+    {
+        char magic[4];
+        shared_graph_reader::read_bytes(magic, 4);
+        if(memcmp(magic, "SPG1", 4) != 0)
+        {
+            shared_graph_reader::m_failed = true;
+        }
+        shared_graph_reader::read(root);
+
+        // Fill in each object, which may reference further objects.
+        for(size_t i = 0; i < shared_graph_reader::m_object_count && !shared_graph_reader::m_failed; ++i)
+        {
+            shared_graph_reader::m_objects[i].read(shared_graph_reader::m_objects[i].object, *this);
+        }
+
+        // Reset the objects of a failed graph, so that cycles among them do not keep them alive.
+        if(shared_graph_reader::m_failed)
+        {
+            root.reset();
+            for(size_t i = 0; i < shared_graph_reader::m_object_count; ++i)
+            {
+                shared_graph_reader::m_objects[i].clear(shared_graph_reader::m_objects[i].object);
+            }
+        }
+
+        // Drop the reader's references, so that only the graph owns its objects.
+        shared_graph_reader::release();
+        return !shared_graph_reader::m_failed;
+    }
+    /// \brief Indicates if the stream ended early or was invalid.
+    /// \return TRUE if reading failed, otherwise FALSE.
+    bool failed() const
+    {
+        return shared_graph_reader::m_failed;
+    }
+
+    // FIELDS
+    /// \brief Reads a reference to an object, creating the object if it has not been referenced before.
+    /// \tparam object_type The type of the object.
+    /// \param reference The reference, set to nullptr if the stream is invalid.
+    template <class object_type>
+    void read(shared_ptr<object_type>& reference)
+    {
+        uint64_t number = shared_graph_reader::read_unsigned();
+        if(number == shared_graph_reader::m_object_count + 1 && !shared_graph_reader::m_failed)
+        {
+            shared_graph_reader::create<object_type>();
+        }
+        if(number == 0 || number > shared_graph_reader::m_object_count ||
+           shared_graph_reader::m_objects[number - 1].release != &shared_graph_reader::release_object<object_type>)
+        {
+            // A number that is not the next one, or that refers to an object of another type, is invalid.
+            shared_graph_reader::m_failed |= number != 0;
+            reference.reset();
+            return;
+        }
+
+        // Share the reader's reference.
+        const object_entry& entry = shared_graph_reader::m_objects[number - 1];
+        entry.count->increment_use_count();
+        reference = shared_ptr<object_type>(static_cast<object_type*>(entry.object), entry.count);
+    }
+    /// \brief Reads an unsigned LEB128 varint.
+    /// \return The value, or 0 if the stream is invalid.
+    uint64_t read_unsigned()
+    {
+        uint64_t value = 0;
+        for(uint8_t shift = 0; shift < 64; shift += 7)
+        {
+            uint8_t byte = 0;
+            shared_graph_reader::read_bytes(&byte, 1);
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if(!(byte & 0x80))
+            {
+                return shared_graph_reader::m_failed ? 0 : value;
+            }
+        }
+        shared_graph_reader::m_failed = true;
+        return 0;
+    }
+    /// \brief Reads a zigzag encoded LEB128 varint.
+    /// \return The value, or 0 if the stream is invalid.
+    int64_t read_signed()
+    {
+        uint64_t value = shared_graph_reader::read_unsigned();
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+    /// \brief Reads the bytes of a trivially copyable value written by shared_graph_writer::write_value().
+    /// \tparam value_type The type of the value.
+    /// \param value The value to read into.
+    template <class value_type>
+    void read_value(value_type& value)
+    {
+        shared_graph_reader::read_bytes(&value, sizeof(value_type));
+    }
+    /// \brief Reads raw bytes. The bytes are zeroed if the stream ends early.
+    /// \param data The buffer to read into.
+    /// \param size The number of bytes.
+    void read_bytes(void* data, size_t size)
+    {
+        if(shared_graph_reader::m_failed || shared_graph_reader::m_reader(static_cast<uint8_t*>(data), size, shared_graph_reader::m_context) != size)
+        {
+            shared_graph_reader::m_failed = true;
+            memset(data, 0, size);
+        }
+    }
+
+private:
+    // INPUT
+    /// \brief The function that reads the stream.
+    reader_type m_reader;
+    /// \brief The context passed to the reader.
+    void* m_context;
+    /// \brief Indicates if the stream ended early or was invalid.
+    bool m_failed;
+
+    // OBJECTS
+    /// \brief A restored object, referenced by the reader until the graph is read.
+    struct object_entry
+    {
+        /// \brief The object.
+        void* object;
+        /// \brief The control block of the object.
+        shared_count* count;
+        /// \brief Fills in the object from the stream.
+        void (*read)(void* object, shared_graph_reader& reader);
+        /// \brief Replaces the object with a default constructed one.
+        void (*clear)(void* object);
+        /// \brief Releases the reader's reference to the object. Also identifies the type of the object.
+        void (*release)(void* object, shared_count* count);
+    };
+    /// \brief The restored objects, in the order of their numbers.
+    object_entry* m_objects;
+    /// \brief The number of restored objects.
+    size_t m_object_count;
+    /// \brief The capacity of m_objects.
+    size_t m_object_capacity;
+
+    // ARENA
+    /// \brief The size of the arena chunks in bytes, or 0 to allocate each object separately.
+    size_t m_arena_chunk;
+    /// \brief The current arena chunk, or nullptr.
+    shared_graph_chunk* m_chunk;
+    /// \brief The number of bytes used in the current arena chunk.
+    size_t m_chunk_used;
+
+    /// \brief Creates the next object, and references it until the graph is read.
+    /// \tparam object_type The type of the object.
+    template <class object_type>
+    void create()
+    {
+        // Grow the object list if it is full.
+        if(shared_graph_reader::m_object_count == shared_graph_reader::m_object_capacity)
+        {
+            size_t capacity = shared_graph_reader::m_object_capacity ? 2 * shared_graph_reader::m_object_capacity : 16;
+            object_entry* objects = new object_entry[capacity];
+            if(shared_graph_reader::m_object_count)
+            {
+                memcpy(objects, shared_graph_reader::m_objects, shared_graph_reader::m_object_count * sizeof(object_entry));
+            }
+            delete[] shared_graph_reader::m_objects;
+            shared_graph_reader::m_objects = objects;
+            shared_graph_reader::m_object_capacity = capacity;
+        }
+
+        // Allocate the object separately or in the arena.
+        object_entry& entry = shared_graph_reader::m_objects[shared_graph_reader::m_object_count];
+        if(shared_graph_reader::m_arena_chunk)
+        {
+            void* memory = shared_graph_reader::allocate(sizeof(shared_graph_block<object_type>), alignof(shared_graph_block<object_type>));
+            shared_graph_block<object_type>* block = new (memory) shared_graph_block<object_type>(shared_graph_reader::m_chunk);
+            entry.object = &block->object;
+            entry.count = block;
+        }
+        else
+        {
+            shared_ptr<object_type> created = make_shared<object_type>();
+            entry.object = created.m_object;
+            entry.count = created.m_count;
+            created.m_object = nullptr;
+            created.m_count = nullptr;
+        }
+        entry.read = &shared_graph_reader::read_object<object_type>;
+        entry.clear = &shared_graph_reader::clear_object<object_type>;
+        entry.release = &shared_graph_reader::release_object<object_type>;
+        ++shared_graph_reader::m_object_count;
+    }
+    /// \brief Allocates storage for a block in the current arena chunk, starting a new chunk if it does not fit.
+    /// \param size The size of the block in bytes.
+    /// \param alignment The alignment of the block.
+    /// \return A pointer to the storage.
+    void* allocate(size_t size, size_t alignment)
+    {
+        size_t offset = (shared_graph_reader::m_chunk_used + alignment - 1) / alignment * alignment;
+        if(!shared_graph_reader::m_chunk || offset + size > shared_graph_reader::m_chunk->size)
+        {
+            // Start a new chunk, held by the reader until the next one starts.
+            shared_graph_reader::release_chunk();
+            offset = (sizeof(shared_graph_chunk) + alignment - 1) / alignment * alignment;
+            shared_graph_reader::m_chunk = shared_graph_chunk::allocate(offset + size > shared_graph_reader::m_arena_chunk ? offset + size : shared_graph_reader::m_arena_chunk);
+        }
+
+        ++shared_graph_reader::m_chunk->live;
+        shared_graph_reader::m_chunk_used = offset + size;
+        return reinterpret_cast<uint8_t*>(shared_graph_reader::m_chunk) + offset;
+    }
+    /// \brief Drops the reader's hold on the current arena chunk.
+    void release_chunk()
+    {
+        if(shared_graph_reader::m_chunk)
+        {
+            shared_graph_chunk::release(shared_graph_reader::m_chunk);
+        }
+        shared_graph_reader::m_chunk = nullptr;
+    }
+    /// \brief Releases the reader's references to the restored objects and the current arena chunk.
+    void release()
+    {
+        for(size_t i = 0; i < shared_graph_reader::m_object_count; ++i)
+        {
+            shared_graph_reader::m_objects[i].release(shared_graph_reader::m_objects[i].object, shared_graph_reader::m_objects[i].count);
+        }
+        delete[] shared_graph_reader::m_objects;
+        shared_graph_reader::m_objects = nullptr;
+        shared_graph_reader::m_object_count = 0;
+        shared_graph_reader::m_object_capacity = 0;
+        shared_graph_reader::release_chunk();
+    }
+    /// \brief Fills in an object through its traits.
+    /// \tparam object_type The type of the object.
+    /// \param object The object.
+    /// \param reader The reader.
+    template <class object_type>
+    static void read_object(void* object, shared_graph_reader& reader)
+    {
+        shared_graph_traits<object_type>::read(*static_cast<object_type*>(object), reader);
+    }
+    /// \brief Replaces an object with a default constructed one, releasing the references it holds.
+    /// \tparam object_type The type of the object.
+    /// \param object The object.
+    template <class object_type>
+    static void clear_object(void* object)
+    {
+        static_cast<object_type*>(object)->~object_type();
+        new (object) object_type();
+    }
+    /// \brief Releases a reference to an object.
+    /// \tparam object_type The type of the object.
+    /// \param object The object.
+    /// \param count The control block of the object.
+    template <class object_type>
+    static void release_object(void* object, shared_count* count)
+    {
+        shared_ptr<object_type> released(static_cast<object_type*>(object), count);
+    }
+
+#ifndef ARDUINO
+    /// \brief Reads stream data from a file.
+    /// \param data The buffer to read into.
+    /// \param size The number of bytes to read.
+    /// \param context The FILE to read from.
+    /// \return The number of bytes read.
+    static size_t read_file(uint8_t* data, size_t size, void* context)
+    {
+        return fread(data, 1, size, static_cast<FILE*>(context));
+    }
+#endif
+};
+
+#endif
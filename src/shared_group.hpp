@@ -0,0 +1,280 @@
+/// \file shared_group.hpp
+/// \brief Defines the shared_group class.
+#ifndef SMART_PTR___SHARED_GROUP_H
+#define SMART_PTR___SHARED_GROUP_H
+
+#include <shared_ptr.hpp>
+
+#include <new>
+
+/// \brief The reference counts of a group of objects, allocated together with the objects.
+/// \details The objects are stored contiguously after the counts, in the same allocation.
+/// \tparam object_type The type of the objects.
+template <class object_type>
+class shared_group_count
+    : public shared_count
+{
+public:
+    // ALLOCATION
+    /// \brief Allocates the counts and storage for a group of objects.
+    /// \details The objects are not constructed.
+    /// \param size The number of objects in the group.
+    /// \return The new counts, with a use count of one.
+    static shared_group_count<object_type>* allocate(size_t size)
+    {
+        return shared_group_count::allocate(size, 0, &shared_group_count::manage);
+    }
+    /// \brief Allocates the counts and storage for one object followed by trailing data.
+    /// \details The object is not constructed. The counts are marked, so that trailing() recognizes them.
+    /// \param trailing_bytes The number of bytes to reserve directly after the object.
+    /// \return The new counts, with a use count of one.
+    static shared_group_count<object_type>* allocate_trailing(size_t trailing_bytes)
+    {
+        return shared_group_count::allocate(1, trailing_bytes, &shared_group_count::manage_trailing);
+    }
+
+    // QUERY
+    /// \brief Indicates if counts belong to an object followed by trailing data.
+    /// \details Such an object cannot be moved out of its allocation without losing the trailing data.
+    /// \param count The counts.
+    /// \return TRUE if the counts were created by allocate_trailing(), otherwise FALSE.
+    static bool trailing(const shared_count& count)
+    {
+        return count.has_manager(&shared_group_count::manage_trailing);
+    }
+
+    // OBJECTS
+    /// \brief Gets the storage of the objects.
+    /// \return A pointer to the first object.
+    object_type* objects()
+    {
+        return reinterpret_cast<object_type*>(reinterpret_cast<uint8_t*>(this) + shared_group_count::offset());
+    }
+    /// \brief Gets the number of objects in the group.
+    /// \return The number of objects.
+    size_t size() const
+    {
+        return shared_group_count::m_size;
+    }
+
+private:
+    // CONSTRUCTORS
+    /// \brief Creates a new shared_group_count instance.
+    /// \param size The number of objects in the group.
+    /// \param manager The manager of the group.
+    shared_group_count(size_t size, shared_count::manager_type manager)
+        : shared_count(manager),
+          m_size(size)
+    {}
+
+    // ALLOCATION
+    /// \brief Allocates the counts and storage for a group of objects.
+    /// \param size The number of objects in the group.
+    /// \param trailing_bytes The number of bytes to reserve directly after the last object.
+    /// \param manager The manager of the group.
+    /// \return The new counts, with a use count of one.
+    static shared_group_count<object_type>* allocate(size_t size, size_t trailing_bytes, shared_count::manager_type manager)
+    {
+        size_t bytes = shared_group_count::offset() + size * sizeof(object_type) + trailing_bytes;
+        void* memory = ::operator new(bytes);
+        shared_group_count<object_type>* count = new (memory) shared_group_count<object_type>(size, manager);
+
+        // Report the allocation to the instrumentation tools.
+#ifdef SMART_PTR_INSTRUMENTED
+        count->m_bytes = bytes;
+#endif
+        smart_ptr_hooks::allocate<shared_group_count<object_type>>(memory, bytes);
+
+        return count;
+    }
+
+    // OBJECTS
+    /// \brief The number of objects in the group.
+    size_t m_size;
+#ifdef SMART_PTR_INSTRUMENTED
+    /// \brief The size of the allocation in bytes, reported when it is freed.
+    size_t m_bytes;
+#endif
+
+    // LAYOUT
+    /// \brief Gets the offset of the first object from the start of the allocation.
+    /// \return The size of the counts, rounded up to the alignment of the objects.
+    static size_t offset()
+    {
+        return (sizeof(shared_group_count<object_type>) + alignof(object_type) - 1) / alignof(object_type) * alignof(object_type);
+    }
+
+    // MANAGER
+    /// \brief Destroys the objects or frees the allocation of a group.
+    /// \param count The counts of the group.
+    /// \param action The operation to perform.
+    static void manage(shared_count* count, shared_count::operation action)
+    {
+        shared_group_count<object_type>* group = static_cast<shared_group_count<object_type>*>(count);
+
+        if(action == shared_count::operation::destroy)
+        {
+            // Destroy objects in reverse order of construction.
+            object_type* objects = group->objects();
+            for(size_t i = group->m_size; i > 0; --i)
+            {
+                objects[i - 1].~object_type();
+            }
+        }
+        else
+        {
+#ifdef SMART_PTR_INSTRUMENTED
+            smart_ptr_hooks::free<shared_group_count<object_type>>(group, group->m_bytes);
+#endif
+            group->~shared_group_count();
+            ::operator delete(group);
+        }
+    }
+    /// \brief Manages the group of an object followed by trailing data, marking it for trailing().
+    /// \param count The counts of the group.
+    /// \param action The operation to perform.
+    static void manage_trailing(shared_count* count, shared_count::operation action)
+    {
+        shared_group_count::manage(count, action);
+    }
+};
+
+/// \brief Shared ownership of a contiguous group of objects that share a single allocation and use count.
+/// \details The group is released when the last shared_group or shared_ptr to any of its objects is released.
+/// \tparam object_type The type of the objects.
+template <class object_type>
+class shared_group
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Creates a new, empty shared_group instance.
+    shared_group()
+        : m_size(0)
+    {}
+
+    // ACCESS
+    /// \brief Gets the number of objects in the group.
+    /// \return The number of objects.
+    size_t size() const
+    {
+        return shared_group::m_size;
+    }
+    /// \brief Gets an object by index.
+    /// \param index The index of the object. Must be less than size().
+    /// \return A reference to the object.
+    object_type& operator[](size_t index) const
+    {
+        return shared_group::m_objects.get()[index];
+    }
+    /// \brief Gets the first object, for iterating over the group.
+    /// \return A pointer to the first object.
+    object_type* begin() const
+    {
+        return shared_group::m_objects.get();
+    }
+    /// \brief Gets the end of the group, for iterating over the group.
+    /// \return A pointer past the last object.
+    object_type* end() const
+    {
+        return shared_group::m_objects.get() + shared_group::m_size;
+    }
+    /// \brief Checks if this shared_group references a group of objects.
+    /// \return TRUE if this shared_group references a group, false if it is empty.
+    operator bool() const
+    {
+        return shared_group::m_size != 0;
+    }
+    /// \brief Gets the number of shared_groups and shared_ptrs referencing the group.
+    /// \return The number of references.
+    size_t use_count() const
+    {
+        return shared_group::m_objects.use_count();
+    }
+
+    // SHARING
+    /// \brief Creates a shared_ptr to one object that shares ownership of the whole group.
+    /// \param index The index of the object. Must be less than size().
+    /// \return A shared_ptr to the object.
+    shared_ptr<object_type> share(size_t index) const
+    {
+        shared_group::m_objects.m_count->increment_use_count();
+        return shared_ptr<object_type>(shared_group::m_objects.get() + index, shared_group::m_objects.m_count);
+    }
+
+private:
+    // CONSTRUCTORS
+    /// \brief Creates a new shared_group instance that takes over a newly constructed group.
+    /// \param count The counts of the group, with all objects constructed.
+    shared_group(shared_group_count<object_type>* count)
+        : m_objects(count->objects(), count),
+          m_size(count->size())
+    {}
+
+    // OBJECTS
+    /// \brief A shared_ptr to the first object, which owns the group.
+    shared_ptr<object_type> m_objects;
+    /// \brief The number of objects in the group.
+    size_t m_size;
+
+    template <class other_type, class... args>
+    friend shared_group<other_type> make_shared_n(size_t size, args&&... arguments);
+    template <class other_type>
+    friend shared_group<other_type> make_shared_n_for_overwrite(size_t size);
+    template <class other_type, class... args>
+    friend shared_ptr<other_type> make_shared_trailing(size_t trailing_bytes, args&&... arguments);
+};
+
+// UTILITIES
+/// \brief Creates a group of objects that share a single allocation and use count.
+/// \details The counts and all objects are allocated together, so a group of n objects costs one allocation.
+/// \tparam object_type The type of the objects.
+/// \tparam args The variadic types of the objects' constructor parameters.
+/// \param size The number of objects to create.
+/// \param arguments The arguments to pass to each object's constructor.
+/// \return A shared_group owning the objects, or an empty shared_group if size is zero.
+template <class object_type, class... args>
+shared_group<object_type> make_shared_n(size_t size, args&&... arguments)
+{
+    // Check if there are any objects to create.
+    if(size == 0)
+    {
+        return shared_group<object_type>();
+    }
+
+    // Allocate the group and construct the objects in place.
+    shared_group_count<object_type>* count = shared_group_count<object_type>::allocate(size);
+    object_type* objects = count->objects();
+    for(size_t i = 0; i < size; ++i)
+    {
+        new (objects + i) object_type(arguments...);
+    }
+
+    return shared_group<object_type>(count);
+}
+/// \brief Creates a group of default-initialized objects that share a single allocation and use count.
+/// \details Unlike make_shared_n(), objects of trivial types are left uninitialized, which avoids writing every
+/// byte of a buffer that is about to be overwritten.
+/// \tparam object_type The type of the objects.
+/// \param size The number of objects to create.
+/// \return A shared_group owning the objects, or an empty shared_group if size is zero.
+template <class object_type>
+shared_group<object_type> make_shared_n_for_overwrite(size_t size)
+{
+    // Check if there are any objects to create.
+    if(size == 0)
+    {
+        return shared_group<object_type>();
+    }
+
+    // Allocate the group and default-initialize the objects in place.
+    shared_group_count<object_type>* count = shared_group_count<object_type>::allocate(size);
+    object_type* objects = count->objects();
+    for(size_t i = 0; i < size; ++i)
+    {
+        new (objects + i) object_type;
+    }
+
+    return shared_group<object_type>(count);
+}
+
+#endif
@@ -3,6 +3,246 @@
 #ifndef SMART_PTR___SHARED_PTR_H
 #define SMART_PTR___SHARED_PTR_H
 
+#include <default_delete.hpp>
+#include <smart_ptr_check.hpp>
+#include <smart_ptr_hooks.hpp>
+#ifdef SMART_PTR_TINY_COUNT
+#include <tiny_count.hpp>
+#endif
+
+#include <stdint.h>
+
+#ifdef SMART_PTR_THREAD_CHECKED
+#ifdef ARDUINO
+#error "SMART_PTR_THREAD_CHECKED is only available on hosted builds."
+#endif
+#include <thread>
+#endif
+
+template <class object_type>
+class shared_ptr;
+template <class object_type>
+class weak_ptr;
+template <class... args>
+class event_signal;
+template <class object_type>
+class shared_borrow;
+template <class object_type>
+class shared_group;
+class shared_graph_writer;
+class shared_graph_reader;
+template <class object_type>
+class std_shared_count;
+template <class object_type>
+bool try_unwrap(shared_ptr<object_type>&& pointer, unique_ptr<object_type>& object);
+
+/// \brief The reference counts shared by the shared_ptr and weak_ptr instances of an object.
+/// \details The weak count holds one extra reference on behalf of all shared_ptr instances, so the counts are
+/// freed once the object has been destroyed and no weak references remain.
+/// By default the shared_ptr deletes its object and the counts are a separate allocation. Counts that share an
+/// allocation with their objects instead provide a manager that destroys the objects and frees the allocation.
+/// When SMART_PTR_TINY_COUNT is defined, each count is stored in one byte and spills into a side table past 254.
+/// When SMART_PTR_THREAD_CHECKED is defined on hosted builds, the counts record the thread that created them and trap
+/// if any other thread changes them before transfer() hands them over, since the counts are not atomic.
+class shared_count
+{
+public:
+    // TYPES
+#ifdef SMART_PTR_TINY_COUNT
+    /// \brief The type of the use and weak counts.
+    typedef tiny_count count_type;
+#else
+    /// \brief The type of the use and weak counts.
+    typedef size_t count_type;
+#endif
+    /// \brief The operations performed by a manager.
+    enum class operation : uint8_t
+    {
+        /// \brief Destroy the managed objects.
+        destroy,
+        /// \brief Free the allocation holding the counts.
+        deallocate
+    };
+    /// \brief The type of a function that manages the objects and allocation of a shared_count.
+    typedef void (*manager_type)(shared_count* count, operation action);
+
+    // CONSTRUCTORS
+    /// \brief Creates a new shared_count instance for a single shared_ptr.
+    /// \param manager The manager of the objects and allocation, or nullptr for a separately allocated shared_count.
+    shared_count(manager_type manager = nullptr)
+        : m_use_count(1),
+          m_weak_count(1),
+          m_manager(manager)
+#ifdef SMART_PTR_CHECKED
+          , m_borrow_count(0)
+#endif
+#ifdef SMART_PTR_THREAD_CHECKED
+          , m_thread(std::this_thread::get_id())
+#endif
+    {}
+    shared_count(const shared_count& other) = delete;
+    shared_count& operator=(const shared_count& other) = delete;
+
+    // USE COUNT
+    /// \brief Gets the number of shared_ptrs referencing the object.
+    /// \return The number of shared references.
+    size_t use_count() const
+    {
+        return shared_count::m_use_count;
+    }
+    /// \brief Increments the use count.
+    void increment_use_count()
+    {
+        shared_count::check_thread();
+        ++shared_count::m_use_count;
+    }
+    /// \brief Decrements the use count.
+    /// \return TRUE if the last shared reference was released and the object must be destroyed, otherwise FALSE.
+    bool decrement_use_count()
+    {
+        // Check that the count does not underflow, and that no borrow outlives the last owner.
+        shared_count::check_thread();
+        SMART_PTR_CHECK(shared_count::m_use_count != 0);
+        SMART_PTR_CHECK(shared_count::m_use_count != 1 || shared_count::m_borrow_count == 0);
+
+        return --shared_count::m_use_count == 0;
+    }
+    /// \brief Increments the use count if the object has not been destroyed.
+    /// \return TRUE if the use count was incremented, otherwise FALSE.
+    bool lock()
+    {
+        shared_count::check_thread();
+
+        // Check if the object still exists.
+        if(shared_count::m_use_count == 0)
+        {
+            return false;
+        }
+
+        ++shared_count::m_use_count;
+        return true;
+    }
+
+    // WEAK COUNT
+    /// \brief Increments the weak count.
+    void increment_weak_count()
+    {
+        shared_count::check_thread();
+        ++shared_count::m_weak_count;
+    }
+    /// \brief Decrements the weak count, and frees this shared_count if no references remain.
+    void decrement_weak_count()
+    {
+        shared_count::check_thread();
+        SMART_PTR_CHECK(shared_count::m_weak_count != 0);
+        if(--shared_count::m_weak_count == 0)
+        {
+            // Free the allocation holding the counts.
+            if(shared_count::m_manager)
+            {
+                shared_count::m_manager(this, operation::deallocate);
+            }
+            else
+            {
+                smart_ptr_hooks::free<shared_count>(this, sizeof(shared_count));
+                delete this;
+            }
+        }
+    }
+
+    // OBJECTS
+    /// \brief Indicates if the objects are destroyed by the manager instead of deleted by the shared_ptr.
+    /// \return TRUE if the counts have a manager, otherwise FALSE.
+    bool manages_objects() const
+    {
+        return shared_count::m_manager != nullptr;
+    }
+    /// \brief Indicates if the counts have a given manager, which identifies how they were allocated.
+    /// \param manager The manager.
+    /// \return TRUE if the counts have the manager, otherwise FALSE.
+    bool has_manager(manager_type manager) const
+    {
+        return shared_count::m_manager == manager;
+    }
+    /// \brief Destroys the managed objects through the manager.
+    void destroy_objects()
+    {
+        shared_count::m_manager(this, operation::destroy);
+    }
+
+    // THREAD AFFINITY
+    /// \brief Makes the calling thread the only thread allowed to change the counts. Does nothing unless
+    /// SMART_PTR_THREAD_CHECKED is defined.
+    void transfer()
+    {
+#ifdef SMART_PTR_THREAD_CHECKED
+        shared_count::m_thread = std::this_thread::get_id();
+#endif
+    }
+
+#ifdef SMART_PTR_CHECKED
+    // BORROW COUNT
+    /// \brief Increments the number of live shared_borrows.
+    void increment_borrow_count()
+    {
+        ++shared_count::m_borrow_count;
+    }
+    /// \brief Decrements the number of live shared_borrows.
+    void decrement_borrow_count()
+    {
+        SMART_PTR_CHECK(shared_count::m_borrow_count != 0);
+        --shared_count::m_borrow_count;
+    }
+#endif
+
+private:
+    // COUNTS
+    /// \brief The number of shared_ptrs referencing the object.
+    count_type m_use_count;
+    /// \brief The number of weak references, plus one while any shared_ptr references the object.
+    count_type m_weak_count;
+    /// \brief The manager of the objects and allocation, or nullptr for a separately allocated shared_count.
+    manager_type m_manager;
+#ifdef SMART_PTR_CHECKED
+    /// \brief The number of live shared_borrows of the object.
+    size_t m_borrow_count;
+#endif
+#ifdef SMART_PTR_THREAD_CHECKED
+    /// \brief The thread allowed to change the counts.
+    std::thread::id m_thread;
+#endif
+
+    // THREAD AFFINITY
+    /// \brief Traps if the calling thread is not allowed to change the counts. Does nothing unless
+    /// SMART_PTR_THREAD_CHECKED is defined.
+    void check_thread() const
+    {
+#ifdef SMART_PTR_THREAD_CHECKED
+        if(std::this_thread::get_id() != shared_count::m_thread)
+        {
+            SMART_PTR_TRAP();
+        }
+#endif
+    }
+};
+
+/// \brief Exposes the shared_ptr that links an object to its successor in a chain.
+/// \details Specialize this for node types that hold their successor through a shared_ptr member, so that
+/// releasing the head of a chain releases every successor it was the last owner of in a loop instead of through
+/// recursive destructors. The specialization must be declared before any shared_ptr of the node type is released.
+/// \tparam object_type The type of the object.
+template <class object_type>
+struct shared_ptr_link
+{
+    /// \brief Gets the shared_ptr that references the successor of an object.
+    /// \param object The object.
+    /// \return A pointer to the successor link, or nullptr if the object has no successor link.
+    static shared_ptr<object_type>* next(object_type& /* object */)
+    {
+        return nullptr;
+    }
+};
+
 /// \brief A smart pointer that retains shared ownership of an object through a pointer.
 /// \tparam object_type The type of the object.
 template <class object_type>
@@ -13,33 +253,38 @@ public:
     /// \brief Creates a new, empty shared_ptr instance.
     shared_ptr()
         : m_object(nullptr),
-          m_use_count(nullptr)
+          m_count(nullptr)
     {}
     /// \brief Creates a new shared_ptr instance.
     /// \param pointer A pointer to an object instance to manage.
     shared_ptr(object_type* pointer)
         : m_object(pointer),
-          m_use_count(new size_t(1))
-    {}
+          m_count(new shared_count())
+    {
+        // Report the new allocations to the instrumentation tools.
+        shared_ptr::report_allocation();
+    }
     /// \brief Copy constructs from another shared pointer instance.
     /// \param other The shared_ptr instance to copy.
     shared_ptr(const shared_ptr<object_type>& other)
         : m_object(other.m_object),
-          m_use_count(other.m_use_count)
+          m_count(other.m_count)
     {
         // Increment use count.
         shared_ptr::increment_use_count();
+        smart_ptr_hooks::copy<object_type>(shared_ptr::m_object);
     }
     /// \brief Move constructs from another shared pointer instance.
     /// \param other The shared_ptr instance to move.
     shared_ptr(shared_ptr<object_type>&& other)
         : m_object(other.m_object),
-          m_use_count(other.m_use_count)
+          m_count(other.m_count)
     {
         // Clear other's instance/use count.
         // NOTE: use count remains the same due to move.
+        smart_ptr_hooks::move<object_type>(shared_ptr::m_object);
         other.m_object = nullptr;
-        other.m_use_count = nullptr;
+        other.m_count = nullptr;
     }
     ~shared_ptr()
     {
@@ -56,7 +301,7 @@ public:
 
         // Reset object and use count.
         shared_ptr::m_object = nullptr;
-        shared_ptr::m_use_count = nullptr;
+        shared_ptr::m_count = nullptr;
     }
     /// \brief Resets the shared_ptr to a new instance.
     /// \param pointer The pointer to the new object instance to manage.
@@ -67,7 +312,10 @@ public:
 
         // Store new object and create new reference count.
         shared_ptr::m_object = pointer;
-        shared_ptr::m_use_count = new size_t(1);
+        shared_ptr::m_count = new shared_count();
+
+        // Report the new allocations to the instrumentation tools.
+        shared_ptr::report_allocation();
     }
 
     // ASSIGNMENT
@@ -76,15 +324,19 @@ public:
     /// \return A reference to this shared_ptr.
     shared_ptr<object_type>& operator=(const shared_ptr<object_type>& other)
     {
+        // Increment new use count first, in case both reference the same object.
+        if(other.m_count)
+        {
+            other.m_count->increment_use_count();
+        }
+
         // Decrement current use count.
         shared_ptr::decrement_use_count();
 
         // Copy object and use count.
         shared_ptr::m_object = other.m_object;
-        shared_ptr::m_use_count = other.m_use_count;
-
-        // Increment new use count.
-        shared_ptr::increment_use_count();
+        shared_ptr::m_count = other.m_count;
+        smart_ptr_hooks::copy<object_type>(shared_ptr::m_object);
 
         return *this;
     }
@@ -93,19 +345,22 @@ public:
     /// \return A reference to this shared_ptr.
     shared_ptr<object_type>& operator=(shared_ptr<object_type>&& other)
     {
+        // Take other's object and use count first, since releasing the current object may destroy other.
+        object_type* object = other.m_object;
+        shared_count* count = other.m_count;
+        other.m_object = nullptr;
+        other.m_count = nullptr;
+
         // Decrement current use count.
         shared_ptr::decrement_use_count();
 
-        // Copy object and use count.
-        shared_ptr::m_object = other.m_object;
-        shared_ptr::m_use_count = other.m_use_count;
+        // Store object and use count.
+        shared_ptr::m_object = object;
+        shared_ptr::m_count = count;
 
         // NOTE: Use count for new object remains the same.
+        smart_ptr_hooks::move<object_type>(shared_ptr::m_object);
 
-        // Clear object and use count on other instance.
-        other.m_object = nullptr;
-        other.m_use_count = nullptr;
-        
         return *this;
     }
 
@@ -120,12 +375,14 @@ public:
     /// \return A pointer to the object instance.
     object_type* operator->() const
     {
+        SMART_PTR_CHECK(shared_ptr::m_object);
         return shared_ptr::m_object;
     }
     /// \brief Dereferences the pointer to the managed object instance.
     /// \return A reference to the object instance.
     object_type& operator*() const
     {
+        SMART_PTR_CHECK(shared_ptr::m_object);
         return *shared_ptr::m_object;
     }
     /// \brief Checks if this shared_ptr references an object instance.
@@ -141,9 +398,9 @@ public:
     size_t use_count() const
     {
         // Check if use count exists.
-        if(shared_ptr::m_use_count)
+        if(shared_ptr::m_count)
         {
-            return *shared_ptr::m_use_count;
+            return shared_ptr::m_count->use_count();
         }
         else
         {
@@ -155,9 +412,9 @@ public:
     bool unique() const
     {
         // Check if use count exists.
-        if(shared_ptr::m_use_count)
+        if(shared_ptr::m_count)
         {
-            return *shared_ptr::m_use_count == 1;
+            return shared_ptr::m_count->use_count() == 1;
         }
         else
         {
@@ -165,37 +422,230 @@ public:
         }
     }
 
+    // OWNERSHIP
+    /// \brief Orders this shared_ptr against another by the counts they share rather than by the objects they point to.
+    /// \details Pointers that share ownership of an object are equivalent under this ordering, even if one was
+    /// converted from the other with a different object pointer. Empty pointers are ordered before all others.
+    /// \param other The other shared_ptr.
+    /// \return TRUE if this shared_ptr's counts are ordered before the other's, otherwise FALSE.
+    bool owner_before(const shared_ptr<object_type>& other) const
+    {
+        return reinterpret_cast<uintptr_t>(shared_ptr::m_count) < reinterpret_cast<uintptr_t>(other.m_count);
+    }
+    /// \brief Orders this shared_ptr against a weak_ptr by the counts they share.
+    /// \param other The weak_ptr.
+    /// \return TRUE if this shared_ptr's counts are ordered before the weak_ptr's, otherwise FALSE.
+    bool owner_before(const weak_ptr<object_type>& other) const
+    {
+        return reinterpret_cast<uintptr_t>(shared_ptr::m_count) < reinterpret_cast<uintptr_t>(other.m_count);
+    }
+
+    // THREAD AFFINITY
+    /// \brief Hands the counts of the managed object to the calling thread, which becomes the only thread allowed to
+    /// copy or release its shared_ptrs and weak_ptrs. Does nothing unless SMART_PTR_THREAD_CHECKED is defined.
+    /// \details Call this on the receiving thread after every reference has been handed over, for example after
+    /// moving the last shared_ptr through a queue.
+    void transfer()
+    {
+        if(shared_ptr::m_count)
+        {
+            shared_ptr::m_count->transfer();
+        }
+    }
+
 private:
+    // CONSTRUCTORS
+    /// \brief Creates a new shared_ptr instance that takes over an existing shared reference.
+    /// \param object A pointer to the managed object instance.
+    /// \param count The reference counts of the object instance, already incremented for this shared_ptr.
+    shared_ptr(object_type* object, shared_count* count)
+        : m_object(object),
+          m_count(count)
+    {}
+
     // OBJECT
     /// \brief A pointer to the shared object instance.
     object_type* m_object;
-    /// \brief A pointer to the shared reference count of the object instance.
-    size_t* m_use_count;
+    /// \brief A pointer to the shared reference counts of the object instance.
+    shared_count* m_count;
 
     // USE COUNT
     /// \brief Decrements the use count of the shared object, and frees it if no more references exist.
+    /// \details Successors that this was the last reference to are released in a loop, so the stack depth stays constant.
     void decrement_use_count()
     {
+        object_type* object = shared_ptr::m_object;
+        shared_count* count = shared_ptr::m_count;
+
         // Decrement use count and check if its zero.
-        if(shared_ptr::m_use_count && --(*shared_ptr::m_use_count) == 0)
+        while(count && count->decrement_use_count())
         {
+            // Report the last release to the instrumentation tools.
+            smart_ptr_hooks::release<object_type>(object);
+
+            // Detach the successor so that deleting the object does not recurse into it.
+            shared_ptr<object_type>* link = object ? shared_ptr_link<object_type>::next(*object) : nullptr;
+            object_type* next_object = nullptr;
+            shared_count* next_count = nullptr;
+            if(link)
+            {
+                next_object = link->m_object;
+                next_count = link->m_count;
+                link->m_object = nullptr;
+                link->m_count = nullptr;
+            }
+
             // Clean up managed object.
-            delete shared_ptr::m_object;
-            // Clean up use count.
-            delete shared_ptr::m_use_count;
+            if(count->manages_objects())
+            {
+                count->destroy_objects();
+            }
+            else if(object)
+            {
+                smart_ptr_hooks::free<object_type>(object, sizeof(object_type));
+                delete object;
+            }
+            // Release the shared references' hold on the reference counts.
+            count->decrement_weak_count();
+
+            // Continue with the successor's reference.
+            object = next_object;
+            count = next_count;
+        }
+    }
+    /// \brief Reports a newly adopted object and its separately allocated counts to the instrumentation tools.
+    void report_allocation()
+    {
+        if(shared_ptr::m_object)
+        {
+            smart_ptr_hooks::allocate<object_type>(shared_ptr::m_object, sizeof(object_type));
         }
+        smart_ptr_hooks::allocate<shared_count>(shared_ptr::m_count, sizeof(shared_count));
     }
     /// \brief Increments the use count of the shared object.
     void increment_use_count()
     {
         // Check if there is a managed object.
-        if(shared_ptr::m_use_count)
+        if(shared_ptr::m_count)
         {
-            ++(*shared_ptr::m_use_count);
+            shared_ptr::m_count->increment_use_count();
         }
     }
+
+    friend class weak_ptr<object_type>;
+    friend class shared_borrow<object_type>;
+    friend class shared_group<object_type>;
+    template <class other_type>
+    friend bool try_unwrap(shared_ptr<other_type>&& pointer, unique_ptr<other_type>& object);
+    template <class other_type>
+    friend bool try_unwrap(shared_ptr<other_type>&& pointer, other_type& object);
+    template <class... args>
+    friend class event_signal;
+    friend class shared_graph_writer;
+    friend class shared_graph_reader;
+    template <class other_type>
+    friend class std_shared_count;
 };
 
+// COMPARISON
+/// \brief Checks if two shared_ptrs point to the same object.
+/// \tparam object_type The type of the object.
+/// \param a The first shared_ptr.
+/// \param b The second shared_ptr.
+/// \return TRUE if both point to the same object or are both empty, otherwise FALSE.
+template <class object_type>
+bool operator==(const shared_ptr<object_type>& a, const shared_ptr<object_type>& b)
+{
+    return a.get() == b.get();
+}
+/// \brief Checks if two shared_ptrs point to different objects.
+/// \tparam object_type The type of the object.
+/// \param a The first shared_ptr.
+/// \param b The second shared_ptr.
+/// \return TRUE if they point to different objects, otherwise FALSE.
+template <class object_type>
+bool operator!=(const shared_ptr<object_type>& a, const shared_ptr<object_type>& b)
+{
+    return a.get() != b.get();
+}
+/// \brief Orders two shared_ptrs by the address of their objects.
+/// \details Addresses are compared as integers, so the order is total even across separate allocations.
+/// \tparam object_type The type of the object.
+/// \param a The first shared_ptr.
+/// \param b The second shared_ptr.
+/// \return TRUE if a's object is ordered before b's, otherwise FALSE.
+template <class object_type>
+bool operator<(const shared_ptr<object_type>& a, const shared_ptr<object_type>& b)
+{
+    return reinterpret_cast<uintptr_t>(a.get()) < reinterpret_cast<uintptr_t>(b.get());
+}
+/// \brief Orders two shared_ptrs by the address of their objects.
+/// \tparam object_type The type of the object.
+/// \param a The first shared_ptr.
+/// \param b The second shared_ptr.
+/// \return TRUE if a's object is ordered after b's, otherwise FALSE.
+template <class object_type>
+bool operator>(const shared_ptr<object_type>& a, const shared_ptr<object_type>& b)
+{
+    return b < a;
+}
+/// \brief Orders two shared_ptrs by the address of their objects.
+/// \tparam object_type The type of the object.
+/// \param a The first shared_ptr.
+/// \param b The second shared_ptr.
+/// \return TRUE if a's object is not ordered after b's, otherwise FALSE.
+template <class object_type>
+bool operator<=(const shared_ptr<object_type>& a, const shared_ptr<object_type>& b)
+{
+    return !(b < a);
+}
+/// \brief Orders two shared_ptrs by the address of their objects.
+/// \tparam object_type The type of the object.
+/// \param a The first shared_ptr.
+/// \param b The second shared_ptr.
+/// \return TRUE if a's object is not ordered before b's, otherwise FALSE.
+template <class object_type>
+bool operator>=(const shared_ptr<object_type>& a, const shared_ptr<object_type>& b)
+{
+    return !(a < b);
+}
+/// \brief Checks if a shared_ptr is empty.
+/// \tparam object_type The type of the object.
+/// \param pointer The shared_ptr.
+/// \return TRUE if the shared_ptr is empty, otherwise FALSE.
+template <class object_type>
+bool operator==(const shared_ptr<object_type>& pointer, decltype(nullptr))
+{
+    return !pointer;
+}
+/// \brief Checks if a shared_ptr is empty.
+/// \tparam object_type The type of the object.
+/// \param pointer The shared_ptr.
+/// \return TRUE if the shared_ptr is empty, otherwise FALSE.
+template <class object_type>
+bool operator==(decltype(nullptr), const shared_ptr<object_type>& pointer)
+{
+    return !pointer;
+}
+/// \brief Checks if a shared_ptr is not empty.
+/// \tparam object_type The type of the object.
+/// \param pointer The shared_ptr.
+/// \return TRUE if the shared_ptr points to an object, otherwise FALSE.
+template <class object_type>
+bool operator!=(const shared_ptr<object_type>& pointer, decltype(nullptr))
+{
+    return static_cast<bool>(pointer);
+}
+/// \brief Checks if a shared_ptr is not empty.
+/// \tparam object_type The type of the object.
+/// \param pointer The shared_ptr.
+/// \return TRUE if the shared_ptr points to an object, otherwise FALSE.
+template <class object_type>
+bool operator!=(decltype(nullptr), const shared_ptr<object_type>& pointer)
+{
+    return static_cast<bool>(pointer);
+}
+
 // UTILITIES
 /// \brief Creates a shared_ptr managing a new instance of an object.
 /// \tparam object_type The type of the object.
@@ -207,5 +657,15 @@ shared_ptr<object_type> make_shared(args&&... arguments)
 {
     return shared_ptr<object_type>(new object_type(arguments...));
 }
+/// \brief Creates a shared_ptr managing a new, default-initialized instance of an object.
+/// \details Unlike make_shared(), members without a default member initializer are left uninitialized, which
+/// avoids writing every byte of a buffer that is about to be overwritten.
+/// \tparam object_type The type of the object.
+/// \return A shared_ptr managing a new instance of the object.
+template <class object_type>
+shared_ptr<object_type> make_shared_for_overwrite()
+{
+    return shared_ptr<object_type>(new object_type);
+}
 
-#endif
\ No newline at end of file
+#endif
@@ -5,5 +5,24 @@
 
 #include <shared_ptr.hpp>
 #include <unique_ptr.hpp>
+#include <weak_ptr.hpp>
+#include <shared_borrow.hpp>
+#include <shared_group.hpp>
+#include <not_null_shared.hpp>
+#include <not_null_unique.hpp>
+#include <tagged_unique_ptr.hpp>
+#include <try_unwrap.hpp>
+#include <trailing.hpp>
+#include <event_signal.hpp>
+#include <lazy_shared.hpp>
+#include <persistent_vector.hpp>
+#include <persistent_map.hpp>
+#include <gc_ptr.hpp>
+#include <compact_ptr.hpp>
+#include <deferred_ptr.hpp>
+#include <shared_graph.hpp>
+#include <ptr_hash.hpp>
+#include <flat_ptr_set.hpp>
+#include <flat_ptr_map.hpp>
 
 #endif
\ No newline at end of file
@@ -0,0 +1,23 @@
+/// \file smart_ptr_check.hpp
+/// \brief Defines the runtime checks of the smart_ptr library.
+/// \details Define SMART_PTR_CHECKED before including the library to enable checks that trap on misuse. When it is
+/// not defined, every check compiles to nothing.
+#ifndef SMART_PTR___SMART_PTR_CHECK_H
+#define SMART_PTR___SMART_PTR_CHECK_H
+
+#include <stdlib.h>
+
+#ifndef SMART_PTR_TRAP
+/// \brief Stops the program when a check fails. May be defined before including the library to customize it.
+#define SMART_PTR_TRAP() abort()
+#endif
+
+#ifdef SMART_PTR_CHECKED
+/// \brief Traps if a condition does not hold.
+#define SMART_PTR_CHECK(condition) do { if(!(condition)) { SMART_PTR_TRAP(); } } while(0)
+#else
+/// \brief Traps if a condition does not hold. Disabled unless SMART_PTR_CHECKED is defined.
+#define SMART_PTR_CHECK(condition) do {} while(0)
+#endif
+
+#endif
@@ -0,0 +1,22 @@
+/// \file smart_ptr_clock.hpp
+/// \brief Defines the clock used by the instrumentation tools of the smart_ptr library.
+/// \details SMART_PTR_CLOCK() may be defined before including the library to use a different clock. It must return
+/// a uint32_t timestamp in microseconds, and may wrap around.
+#ifndef SMART_PTR___SMART_PTR_CLOCK_H
+#define SMART_PTR___SMART_PTR_CLOCK_H
+
+#include <stdint.h>
+
+#ifndef SMART_PTR_CLOCK
+#ifdef ARDUINO
+#include <Arduino.h>
+/// \brief Gets the current time in microseconds.
+#define SMART_PTR_CLOCK() static_cast<uint32_t>(micros())
+#else
+#include <chrono>
+/// \brief Gets the current time in microseconds.
+#define SMART_PTR_CLOCK() static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count())
+#endif
+#endif
+
+#endif
@@ -0,0 +1,149 @@
+/// \file smart_ptr_hooks.hpp
+/// \brief Defines the instrumentation hooks of the smart_ptr library.
+/// \details The smart pointers report their allocations and frees through smart_ptr_hooks, which forwards them to
+/// the instrumentation tools enabled at compile time. When no tool is enabled, the hooks compile to nothing.
+#ifndef SMART_PTR___SMART_PTR_HOOKS_H
+#define SMART_PTR___SMART_PTR_HOOKS_H
+
+#include <stddef.h>
+
+#if defined(SMART_PTR_PROFILE) && defined(ARDUINO)
+#error "SMART_PTR_PROFILE is only available on hosted builds."
+#endif
+#if defined(SMART_PTR_EVENT_TRACE) && defined(ARDUINO)
+#error "SMART_PTR_EVENT_TRACE is only available on hosted builds."
+#endif
+#if defined(SMART_PTR_TELEMETRY) && defined(ARDUINO)
+#error "SMART_PTR_TELEMETRY is only available on hosted builds."
+#endif
+
+#if defined(SMART_PTR_TRACE) || defined(SMART_PTR_PROFILE) || defined(SMART_PTR_LIFETIME) || defined(SMART_PTR_EVENT_TRACE) || \
+    defined(SMART_PTR_TELEMETRY)
+/// \brief Defined when any instrumentation tool is enabled.
+#define SMART_PTR_INSTRUMENTED
+#endif
+
+#ifdef SMART_PTR_TRACE
+#include <allocation_trace.hpp>
+#endif
+#ifdef SMART_PTR_PROFILE
+#include <allocation_profiler.hpp>
+#endif
+#ifdef SMART_PTR_LIFETIME
+#include <lifetime_histogram.hpp>
+#endif
+#ifdef SMART_PTR_EVENT_TRACE
+#include <ownership_trace.hpp>
+#endif
+#ifdef SMART_PTR_TELEMETRY
+#include <memory_telemetry.hpp>
+#endif
+
+/// \brief Forwards the allocations and frees of the smart pointers to the enabled instrumentation tools.
+struct smart_ptr_hooks
+{
+    /// \brief Reports that the library took ownership of a new allocation.
+    /// \tparam object_type The type of the allocation.
+    /// \param address The address of the allocation.
+    /// \param size The size of the allocation in bytes.
+    template <class object_type>
+    static void allocate(const void* address, size_t size)
+    {
+        // Every tool may be disabled.
+        (void)address;
+        (void)size;
+
+#ifdef SMART_PTR_TRACE
+        allocation_trace::allocate(smart_ptr_type::of<object_type>(), address, size);
+#endif
+#ifdef SMART_PTR_PROFILE
+        allocation_profiler::allocate(address, size);
+#endif
+#ifdef SMART_PTR_LIFETIME
+        lifetime_histogram::allocate(smart_ptr_type::of<object_type>(), address);
+#endif
+#ifdef SMART_PTR_EVENT_TRACE
+        ownership_trace::record(ownership_trace::kind::allocate, smart_ptr_type::of<object_type>(), address, size);
+#endif
+#ifdef SMART_PTR_TELEMETRY
+        memory_telemetry::allocate(smart_ptr_type::of<object_type>(), size);
+#endif
+    }
+    /// \brief Reports that the library is about to free an allocation, or give up ownership of it.
+    /// \tparam object_type The type of the allocation.
+    /// \param address The address of the allocation.
+    /// \param size The size of the allocation in bytes.
+    template <class object_type>
+    static void free(const void* address, size_t size)
+    {
+        // Every tool may be disabled.
+        (void)address;
+        (void)size;
+
+#ifdef SMART_PTR_TRACE
+        allocation_trace::free(address);
+#endif
+#ifdef SMART_PTR_PROFILE
+        allocation_profiler::free(address);
+#endif
+#ifdef SMART_PTR_LIFETIME
+        lifetime_histogram::free(address);
+#endif
+#ifdef SMART_PTR_EVENT_TRACE
+        ownership_trace::record(ownership_trace::kind::free, smart_ptr_type::of<object_type>(), address, size);
+#endif
+#ifdef SMART_PTR_TELEMETRY
+        memory_telemetry::free(smart_ptr_type::of<object_type>(), size);
+#endif
+    }
+    /// \brief Reports that a shared_ptr was copied.
+    /// \tparam object_type The type of the object.
+    /// \param object The object, or nullptr if the copy is empty.
+    template <class object_type>
+    static void copy(const object_type* object)
+    {
+        // The event trace may be disabled.
+        (void)object;
+
+#ifdef SMART_PTR_EVENT_TRACE
+        if(object)
+        {
+            ownership_trace::record(ownership_trace::kind::copy, smart_ptr_type::of<object_type>(), object, 0);
+        }
+#endif
+    }
+    /// \brief Reports that a shared_ptr or unique_ptr was moved.
+    /// \tparam object_type The type of the object.
+    /// \param object The object, or nullptr if the moved pointer is empty.
+    template <class object_type>
+    static void move(const object_type* object)
+    {
+        // The event trace may be disabled.
+        (void)object;
+
+#ifdef SMART_PTR_EVENT_TRACE
+        if(object)
+        {
+            ownership_trace::record(ownership_trace::kind::move, smart_ptr_type::of<object_type>(), object, 0);
+        }
+#endif
+    }
+    /// \brief Reports that the last shared_ptr to an object was released, before the object is destroyed.
+    /// \tparam object_type The type of the object.
+    /// \param object The object, or nullptr if the released shared_ptr was empty.
+    template <class object_type>
+    static void release(const object_type* object)
+    {
+        // The event trace may be disabled.
+        (void)object;
+
+#ifdef SMART_PTR_EVENT_TRACE
+        if(object)
+        {
+            ownership_trace::record(ownership_trace::kind::release, smart_ptr_type::of<object_type>(), object, 0);
+        }
+#endif
+    }
+};
+
+#endif
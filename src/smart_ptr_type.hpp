@@ -0,0 +1,136 @@
+/// \file smart_ptr_type.hpp
+/// \brief Defines the smart_ptr_type class.
+#ifndef SMART_PTR___SMART_PTR_TYPE_H
+#define SMART_PTR___SMART_PTR_TYPE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef ARDUINO
+#include <mutex>
+#endif
+
+/// \brief Identifies a type managed by the smart pointers, for the instrumentation tools.
+/// \details Each type is registered the first time of<object_type>() is called for it, and receives the next
+/// sequential index, so tools can keep per-type data in arrays. The name is taken from the compiler's function
+/// signature, since RTTI is not available on all platforms.
+class smart_ptr_type
+{
+public:
+    // REGISTRY
+    /// \brief Gets the registered type of a C++ type, registering it on first use.
+    /// \tparam object_type The C++ type.
+    /// \return A reference to the registered type.
+    template <class object_type>
+    static smart_ptr_type& of()
+    {
+#if defined(__GNUC__)
+        static smart_ptr_type type(__PRETTY_FUNCTION__);
+#else
+        static smart_ptr_type type("object_type = ?]");
+#endif
+        return type;
+    }
+    /// \brief Gets the number of registered types.
+    /// \return The number of registered types.
+    static uint16_t count()
+    {
+#ifndef ARDUINO
+        std::lock_guard<std::mutex> lock(smart_ptr_type::registry().mutex);
+#endif
+        return smart_ptr_type::registry().count;
+    }
+    /// \brief Gets the first registered type, for iterating over all registered types.
+    /// \return A pointer to the most recently registered type, or nullptr if no types are registered.
+    static smart_ptr_type* first()
+    {
+#ifndef ARDUINO
+        std::lock_guard<std::mutex> lock(smart_ptr_type::registry().mutex);
+#endif
+        return smart_ptr_type::registry().head;
+    }
+    /// \brief Gets the next registered type.
+    /// \return A pointer to the type registered before this one, or nullptr if this is the last type.
+    smart_ptr_type* next() const
+    {
+        return smart_ptr_type::m_next;
+    }
+
+    // PROPERTIES
+    /// \brief Gets the index of the type.
+    /// \return The sequential index of the type, less than count().
+    uint16_t index() const
+    {
+        return smart_ptr_type::m_index;
+    }
+    /// \brief Gets the name of the type. The name is not null terminated.
+    /// \return A pointer to the first character of the name.
+    const char* name() const
+    {
+        return smart_ptr_type::m_name;
+    }
+    /// \brief Gets the length of the name of the type.
+    /// \return The number of characters in the name.
+    uint8_t name_length() const
+    {
+        return smart_ptr_type::m_name_length;
+    }
+
+private:
+    // CONSTRUCTORS
+    /// \brief Creates a new smart_ptr_type instance and registers it.
+    /// \param signature The signature of of<object_type>(), which contains the name of the type.
+    smart_ptr_type(const char* signature)
+    {
+        // Extract the type name from "... object_type = name]" or "... object_type = name; ...".
+        const char* name = strstr(signature, "object_type = ");
+        name = name ? name + 14 : signature;
+        size_t length = strcspn(name, ";]");
+        smart_ptr_type::m_name = name;
+        smart_ptr_type::m_name_length = length < 255 ? static_cast<uint8_t>(length) : 255;
+
+        // Add the type to the registry.
+#ifndef ARDUINO
+        std::lock_guard<std::mutex> lock(smart_ptr_type::registry().mutex);
+#endif
+        smart_ptr_type::m_index = smart_ptr_type::registry().count++;
+        smart_ptr_type::m_next = smart_ptr_type::registry().head;
+        smart_ptr_type::registry().head = this;
+    }
+    smart_ptr_type(const smart_ptr_type& other) = delete;
+    smart_ptr_type& operator=(const smart_ptr_type& other) = delete;
+
+    // PROPERTIES
+    /// \brief The name of the type.
+    const char* m_name;
+    /// \brief The length of the name of the type.
+    uint8_t m_name_length;
+    /// \brief The index of the type.
+    uint16_t m_index;
+    /// \brief The type registered before this one.
+    smart_ptr_type* m_next;
+
+    // REGISTRY
+    /// \brief The list of registered types.
+    struct list
+    {
+        /// \brief The most recently registered type.
+        smart_ptr_type* head;
+        /// \brief The number of registered types.
+        uint16_t count;
+#ifndef ARDUINO
+        /// \brief Serializes registration across threads.
+        std::mutex mutex;
+#endif
+    };
+    /// \brief Gets the list of registered types.
+    /// \return A reference to the list.
+    static list& registry()
+    {
+        static list types = {};
+        return types;
+    }
+};
+
+#endif
@@ -0,0 +1,235 @@
+/// \file std_interop.hpp
+/// \brief Defines conversions between the smart pointers and those of the C++ standard library on hosted builds.
+/// \details Ownership moves between unique_ptr and std::unique_ptr without allocating. A shared_ptr converted to a
+/// std::shared_ptr, or the reverse, stays one object shared by both: the new pointer's control block holds a
+/// reference of the original kind, so the object is destroyed once the last pointer of either kind is released.
+/// Converting back returns the original pointer instead of nesting another control block; from a std::shared_ptr
+/// this relies on std::get_deleter, so without RTTI the round trip nests a control block instead. The counts of
+/// shared_ptr are not atomic, so a std::shared_ptr converted from one must still be released on its thread.
+/// std::hash is also specialized for shared_ptr and unique_ptr, so they can key the standard unordered containers.
+#ifndef SMART_PTR___STD_INTEROP_H
+#define SMART_PTR___STD_INTEROP_H
+
+#ifndef ARDUINO
+
+#include <ptr_hash.hpp>
+#include <shared_ptr.hpp>
+#include <unique_ptr.hpp>
+
+#include <functional>
+#include <memory>
+
+/// \brief The control block of a shared_ptr converted from a std::shared_ptr, which holds the std::shared_ptr.
+/// \tparam object_type The type of the object.
+template <class object_type>
+class std_shared_count
+    : public shared_count
+{
+public:
+    // CONVERSION
+    /// \brief Creates a shared_ptr sharing the object of a std::shared_ptr.
+    /// \param pointer The std::shared_ptr.
+    /// \return The shared_ptr, or nullptr if the std::shared_ptr is empty.
+    static shared_ptr<object_type> from_std(const std::shared_ptr<object_type>& pointer)
+    {
+        if(!pointer)
+        {
+            return shared_ptr<object_type>();
+        }
+
+#if defined(__GXX_RTTI) || defined(_CPPRTTI)
+        // Return the original shared_ptr if the std::shared_ptr was converted from one.
+        const holder* original = std::get_deleter<holder>(pointer);
+        if(original && original->pointer.get() == pointer.get())
+        {
+            return original->pointer;
+        }
+#endif
+
+        std_shared_count<object_type>* count = new std_shared_count<object_type>(pointer);
+        smart_ptr_hooks::allocate<std_shared_count<object_type>>(count, sizeof(std_shared_count<object_type>));
+        return shared_ptr<object_type>(pointer.get(), count);
+    }
+    /// \brief Creates a std::shared_ptr sharing the object of a shared_ptr.
+    /// \param pointer The shared_ptr.
+    /// \return The std::shared_ptr, or nullptr if the shared_ptr is empty.
+    static std::shared_ptr<object_type> to_std(const shared_ptr<object_type>& pointer)
+    {
+        if(!pointer)
+        {
+            return std::shared_ptr<object_type>();
+        }
+
+        // Return the original std::shared_ptr if the shared_ptr was converted from one.
+        if(pointer.m_count->has_manager(&std_shared_count::manage))
+        {
+            const std::shared_ptr<object_type>& original = static_cast<std_shared_count<object_type>*>(pointer.m_count)->m_pointer;
+            if(original.get() == pointer.get())
+            {
+                return original;
+            }
+        }
+
+        return std::shared_ptr<object_type>(pointer.get(), holder{pointer});
+    }
+
+private:
+    // CONSTRUCTORS
+    /// \brief Creates a new std_shared_count instance.
+    /// \param pointer The std::shared_ptr to hold.
+    std_shared_count(const std::shared_ptr<object_type>& pointer)
+        : shared_count(&std_shared_count::manage),
+          m_pointer(pointer)
+    {}
+
+    // OWNER
+    /// \brief The std::shared_ptr that owns the object.
+    std::shared_ptr<object_type> m_pointer;
+
+    /// \brief The deleter of a std::shared_ptr converted from a shared_ptr, which holds the shared_ptr.
+    struct holder
+    {
+        /// \brief The shared_ptr that owns the object.
+        shared_ptr<object_type> pointer;
+
+        /// \brief Releases the shared_ptr once the last std::shared_ptr is released.
+        void operator()(object_type*)
+        {
+            holder::pointer.reset();
+        }
+    };
+
+    // MANAGER
+    /// \brief Releases the std::shared_ptr or frees the counts.
+    /// \param count The counts.
+    /// \param action The operation to perform.
+    static void manage(shared_count* count, shared_count::operation action)
+    {
+        std_shared_count<object_type>* converted = static_cast<std_shared_count<object_type>*>(count);
+
+        if(action == shared_count::operation::destroy)
+        {
+            converted->m_pointer.reset();
+        }
+        else
+        {
+            smart_ptr_hooks::free<std_shared_count<object_type>>(converted, sizeof(std_shared_count<object_type>));
+            delete converted;
+        }
+    }
+};
+
+// SHARED
+/// \brief Converts a shared_ptr to a std::shared_ptr sharing the same object.
+/// \tparam object_type The type of the object.
+/// \param pointer The shared_ptr.
+/// \return The std::shared_ptr, or nullptr if the shared_ptr is empty.
+template <class object_type>
+std::shared_ptr<object_type> to_std(const shared_ptr<object_type>& pointer)
+{
+    return std_shared_count<object_type>::to_std(pointer);
+}
+/// \brief Converts a std::shared_ptr to a shared_ptr sharing the same object.
+/// \tparam object_type The type of the object.
+/// \param pointer The std::shared_ptr.
+/// \return The shared_ptr, or nullptr if the std::shared_ptr is empty.
+template <class object_type>
+shared_ptr<object_type> from_std(const std::shared_ptr<object_type>& pointer)
+{
+    return std_shared_count<object_type>::from_std(pointer);
+}
+
+// UNIQUE
+/// \brief Moves the object of a unique_ptr into a std::unique_ptr.
+/// \tparam object_type The type of the object.
+/// \param pointer The unique_ptr, which is left empty.
+/// \return The std::unique_ptr owning the object.
+template <class object_type>
+std::unique_ptr<object_type> to_std(unique_ptr<object_type>&& pointer)
+{
+    return std::unique_ptr<object_type>(pointer.release());
+}
+/// \brief Moves the array of a unique_ptr into a std::unique_ptr.
+/// \tparam object_type The type of the array's elements.
+/// \param pointer The unique_ptr, which is left empty.
+/// \return The std::unique_ptr owning the array.
+template <class object_type>
+std::unique_ptr<object_type[]> to_std(unique_ptr<object_type[]>&& pointer)
+{
+    return std::unique_ptr<object_type[]>(pointer.release());
+}
+/// \brief Moves the object of a unique_ptr with a custom deleter into a std::unique_ptr with the same deleter.
+/// \tparam object_type The type of the object.
+/// \tparam deleter_type The type of the stateless deleter.
+/// \param pointer The unique_ptr, which is left empty.
+/// \return The std::unique_ptr owning the object.
+template <class object_type, class deleter_type>
+std::unique_ptr<object_type, deleter_type> to_std(unique_ptr<object_type, deleter_type>&& pointer)
+{
+    return std::unique_ptr<object_type, deleter_type>(pointer.release());
+}
+/// \brief Moves the object of a std::unique_ptr into a unique_ptr.
+/// \tparam object_type The type of the object.
+/// \param pointer The std::unique_ptr, which is left empty.
+/// \return The unique_ptr owning the object.
+template <class object_type>
+unique_ptr<object_type> from_std(std::unique_ptr<object_type>&& pointer)
+{
+    return unique_ptr<object_type>(pointer.release());
+}
+/// \brief Moves the array of a std::unique_ptr into a unique_ptr.
+/// \tparam object_type The type of the array's elements.
+/// \param pointer The std::unique_ptr, which is left empty.
+/// \return The unique_ptr owning the array.
+template <class object_type>
+unique_ptr<object_type[]> from_std(std::unique_ptr<object_type[]>&& pointer)
+{
+    return unique_ptr<object_type[]>(pointer.release());
+}
+/// \brief Moves the object of a std::unique_ptr with a stateless custom deleter into a unique_ptr with the same
+/// deleter.
+/// \tparam object_type The type of the object.
+/// \tparam deleter_type The type of the stateless deleter.
+/// \param pointer The std::unique_ptr, which is left empty.
+/// \return The unique_ptr owning the object.
+template <class object_type, class deleter_type>
+unique_ptr<object_type, deleter_type> from_std(std::unique_ptr<object_type, deleter_type>&& pointer)
+{
+    return unique_ptr<object_type, deleter_type>(pointer.release());
+}
+
+// HASH
+namespace std
+{
+    /// \brief Hashes a shared_ptr by the address of its object, for std::unordered_set and std::unordered_map.
+    /// \tparam object_type The type of the object.
+    template <class object_type>
+    struct hash< ::shared_ptr<object_type>>
+    {
+        /// \brief Hashes a shared_ptr.
+        /// \param pointer The shared_ptr to hash.
+        /// \return The hash of the shared_ptr's object address.
+        size_t operator()(const ::shared_ptr<object_type>& pointer) const
+        {
+            return ptr_hash()(pointer);
+        }
+    };
+    /// \brief Hashes a unique_ptr by the address of its object, for std::unordered_set and std::unordered_map.
+    /// \tparam object_type The type of the object.
+    /// \tparam deleter_type The type of the deleter.
+    template <class object_type, class deleter_type>
+    struct hash< ::unique_ptr<object_type, deleter_type>>
+    {
+        /// \brief Hashes a unique_ptr.
+        /// \param pointer The unique_ptr to hash.
+        /// \return The hash of the unique_ptr's object address.
+        size_t operator()(const ::unique_ptr<object_type, deleter_type>& pointer) const
+        {
+            return ptr_hash()(pointer);
+        }
+    };
+}
+
+#endif
+
+#endif
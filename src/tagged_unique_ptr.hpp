@@ -0,0 +1,197 @@
+/// \file tagged_unique_ptr.hpp
+/// \brief Defines the tagged_unique_ptr class.
+#ifndef SMART_PTR___TAGGED_UNIQUE_PTR_H
+#define SMART_PTR___TAGGED_UNIQUE_PTR_H
+
+#include <smart_ptr_check.hpp>
+#include <smart_ptr_hooks.hpp>
+
+#include <stdint.h>
+
+/// \brief A unique_ptr that stores a small tag in the low bits of its pointer, which are zero due to alignment.
+/// \details A tagged_unique_ptr is the size of a plain pointer, so a node can hold a child and a flag or small enum
+/// without padding. The tag is independent of the object: it is kept by reset() and release(), and moved along with
+/// the object. Objects must come from an allocator that guarantees their alignment. Over-aligned types declared with
+/// alignas are not enough where new ignores extended alignment, as avr-libc's malloc and C++11 new do.
+/// \tparam object_type The type of the object.
+/// \tparam bits The number of tag bits. Must be at most log2(alignof(object_type)).
+template <class object_type, uint8_t bits = 1>
+class tagged_unique_ptr
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Creates a new, empty tagged_unique_ptr instance with a tag of zero.
+    tagged_unique_ptr()
+        : m_value(0)
+    {}
+    /// \brief Creates a new tagged_unique_ptr instance.
+    /// \param pointer A pointer to an object instance to manage, whose tag bits must be zero.
+    /// \param tag The initial tag.
+    tagged_unique_ptr(object_type* pointer, uintptr_t tag = 0)
+        : m_value(reinterpret_cast<uintptr_t>(pointer) | (tag & tagged_unique_ptr::tag_mask))
+    {
+        // Check that the allocator aligned the object, so the tag does not corrupt the pointer.
+        SMART_PTR_CHECK((reinterpret_cast<uintptr_t>(pointer) & tagged_unique_ptr::tag_mask) == 0);
+
+        // Report the adopted object to the instrumentation tools.
+        tagged_unique_ptr::report_allocation();
+    }
+    /// \brief Move constructs from another tagged unique pointer instance, including its tag.
+    /// \param other The tagged_unique_ptr instance to move.
+    tagged_unique_ptr(tagged_unique_ptr<object_type, bits>&& other)
+        : m_value(other.m_value)
+    {
+        // Clear other's instance and tag.
+        other.m_value = 0;
+        smart_ptr_hooks::move<object_type>(tagged_unique_ptr::get());
+    }
+    tagged_unique_ptr(const tagged_unique_ptr<object_type, bits>& other) = delete;
+    ~tagged_unique_ptr()
+    {
+        // Check the tag bits here, where the object type is complete even for recursive node types.
+        static_assert((uintptr_t(1) << bits) <= alignof(object_type), "Tag bits exceed the alignment of the object type.");
+
+        // Delete the object instance.
+        tagged_unique_ptr::destroy(tagged_unique_ptr::get());
+    }
+
+    // RESET
+    /// \brief Resets the tagged_unique_ptr to nullptr, keeping its tag.
+    void reset()
+    {
+        tagged_unique_ptr::reset(nullptr);
+    }
+    /// \brief Resets the tagged_unique_ptr to a new instance, keeping its tag.
+    /// \param pointer The pointer to the new object instance to manage, whose tag bits must be zero.
+    void reset(object_type* pointer)
+    {
+        SMART_PTR_CHECK((reinterpret_cast<uintptr_t>(pointer) & tagged_unique_ptr::tag_mask) == 0);
+
+        // Delete old instance and store new instance.
+        tagged_unique_ptr::destroy(tagged_unique_ptr::get());
+        tagged_unique_ptr::m_value = reinterpret_cast<uintptr_t>(pointer) | tagged_unique_ptr::tag();
+
+        // Report the adopted object to the instrumentation tools.
+        tagged_unique_ptr::report_allocation();
+    }
+    /// \brief Releases ownership of the managed object instance without deleting it, keeping the tag.
+    /// \return A pointer to the released object instance.
+    object_type* release()
+    {
+        // Report that the library no longer owns the instance.
+        object_type* object = tagged_unique_ptr::get();
+        if(object)
+        {
+            smart_ptr_hooks::free<object_type>(object, sizeof(object_type));
+        }
+
+        // Clear the instance and hand it to the caller.
+        tagged_unique_ptr::m_value &= tagged_unique_ptr::tag_mask;
+        return object;
+    }
+
+    // ASSIGNMENT
+    /// \brief Move assigns this tagged_unique_ptr from another tagged_unique_ptr, including its tag.
+    /// \param other The tagged_unique_ptr instance to move.
+    /// \return A reference to this tagged_unique_ptr.
+    tagged_unique_ptr<object_type, bits>& operator=(tagged_unique_ptr<object_type, bits>&& other)
+    {
+        // Take other's instance and tag first, since deleting the old instance may destroy other.
+        uintptr_t value = other.m_value;
+        other.m_value = 0;
+
+        // Delete old instance.
+        tagged_unique_ptr::destroy(tagged_unique_ptr::get());
+
+        // Store new instance and tag.
+        tagged_unique_ptr::m_value = value;
+        smart_ptr_hooks::move<object_type>(tagged_unique_ptr::get());
+
+        return *this;
+    }
+    tagged_unique_ptr<object_type, bits>& operator=(const tagged_unique_ptr<object_type, bits>& other) = delete;
+
+    // ACCESS
+    /// \brief Gets the pointer to the managed object instance.
+    /// \return A pointer to the object instance.
+    object_type* get() const
+    {
+        return reinterpret_cast<object_type*>(tagged_unique_ptr::m_value & ~tagged_unique_ptr::tag_mask);
+    }
+    /// \brief Dereferences the pointer to the managed object instance.
+    /// \return A pointer to the object instance.
+    object_type* operator->() const
+    {
+        SMART_PTR_CHECK(tagged_unique_ptr::get());
+        return tagged_unique_ptr::get();
+    }
+    /// \brief Dereferences the pointer to the managed object instance.
+    /// \return A reference to the object instance.
+    object_type& operator*() const
+    {
+        SMART_PTR_CHECK(tagged_unique_ptr::get());
+        return *tagged_unique_ptr::get();
+    }
+    /// \brief Checks if this tagged_unique_ptr references an object instance.
+    /// \return TRUE if this tagged_unique_ptr references an object instance, false if it is nullptr.
+    operator bool() const
+    {
+        return tagged_unique_ptr::get() != nullptr;
+    }
+
+    // TAG
+    /// \brief Gets the tag.
+    /// \return The tag, less than 2^bits.
+    uintptr_t tag() const
+    {
+        return tagged_unique_ptr::m_value & tagged_unique_ptr::tag_mask;
+    }
+    /// \brief Sets the tag without changing the managed object instance.
+    /// \param tag The new tag. Bits above the tag bits are ignored.
+    void set_tag(uintptr_t tag)
+    {
+        tagged_unique_ptr::m_value = (tagged_unique_ptr::m_value & ~tagged_unique_ptr::tag_mask) | (tag & tagged_unique_ptr::tag_mask);
+    }
+
+private:
+    // VALUE
+    /// \brief The mask of the tag bits.
+    static const uintptr_t tag_mask = (uintptr_t(1) << bits) - 1;
+    /// \brief The address of the unique object instance, combined with the tag in its low bits.
+    uintptr_t m_value;
+
+    // INSTRUMENTATION
+    /// \brief Reports a newly adopted object to the instrumentation tools.
+    void report_allocation()
+    {
+        if(object_type* object = tagged_unique_ptr::get())
+        {
+            smart_ptr_hooks::allocate<object_type>(object, sizeof(object_type));
+        }
+    }
+    /// \brief Reports the free of an object instance to the instrumentation tools, and deletes it.
+    /// \param object The object instance, or nullptr.
+    static void destroy(object_type* object)
+    {
+        if(object)
+        {
+            smart_ptr_hooks::free<object_type>(object, sizeof(object_type));
+            delete object;
+        }
+    }
+};
+
+// UTILITIES
+/// \brief Creates a tagged_unique_ptr managing a new instance of an object, with a tag of zero.
+/// \tparam object_type The type of the object.
+/// \tparam bits The number of tag bits.
+/// \tparam args The variadic types of the object's constructor parameters.
+/// \param arguments The arguments to pass to the object's constructor.
+/// \return A tagged_unique_ptr managing a new instance of the object.
+template <class object_type, uint8_t bits = 1, class... args>
+tagged_unique_ptr<object_type, bits> make_tagged_unique(args&&... arguments)
+{
+    return tagged_unique_ptr<object_type, bits>(new object_type(arguments...));
+}
+
+#endif
@@ -0,0 +1,189 @@
+/// \file tiny_count.hpp
+/// \brief Defines the tiny_count class.
+#ifndef SMART_PTR___TINY_COUNT_H
+#define SMART_PTR___TINY_COUNT_H
+
+#include <smart_ptr_check.hpp>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef ARDUINO
+#include <mutex>
+#endif
+
+/// \brief A reference count stored in one byte, which spills into a global side table when it exceeds 254.
+/// \details Counts up to 254 are held inline. The value 255 marks a count that has overflowed, whose value is held
+/// in the side table keyed by the address of the tiny_count, until it drops back to 254. The side table is a list,
+/// since it only holds the rare counts that have overflowed. A tiny_count itself is no more thread safe than the
+/// counts of shared_count, but the side table is shared by every count, so it is locked on hosted builds.
+class tiny_count
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Creates a new tiny_count instance.
+    /// \param value The initial value of the count. Must be less than 255.
+    tiny_count(uint8_t value)
+        : m_value(value)
+    {}
+    tiny_count(const tiny_count& other) = delete;
+    tiny_count& operator=(const tiny_count& other) = delete;
+
+    // VALUE
+    /// \brief Gets the value of the count.
+    /// \return The value of the count.
+    operator size_t() const
+    {
+        // Check if the count is held inline.
+        if(tiny_count::m_value != tiny_count::overflowed)
+        {
+            return tiny_count::m_value;
+        }
+
+        side_table& spilled = tiny_count::table();
+        tiny_count::lock(spilled);
+        size_t value = tiny_count::find(spilled, this)->value;
+        tiny_count::unlock(spilled);
+        return value;
+    }
+    /// \brief Increments the count.
+    /// \return A reference to this tiny_count.
+    tiny_count& operator++()
+    {
+        if(tiny_count::m_value < tiny_count::overflowed - 1)
+        {
+            ++tiny_count::m_value;
+        }
+        else if(tiny_count::m_value == tiny_count::overflowed - 1)
+        {
+            // Spill the count into the side table. The count cannot grow without an entry.
+            entry* added = new entry;
+            if(!added)
+            {
+                SMART_PTR_TRAP();
+                return *this;
+            }
+            added->key = this;
+            added->value = tiny_count::overflowed;
+
+            side_table& spilled = tiny_count::table();
+            tiny_count::lock(spilled);
+            added->next = spilled.head;
+            spilled.head = added;
+            tiny_count::unlock(spilled);
+            tiny_count::m_value = tiny_count::overflowed;
+        }
+        else
+        {
+            side_table& spilled = tiny_count::table();
+            tiny_count::lock(spilled);
+            ++tiny_count::find(spilled, this)->value;
+            tiny_count::unlock(spilled);
+        }
+
+        return *this;
+    }
+    /// \brief Decrements the count.
+    /// \return A reference to this tiny_count.
+    tiny_count& operator--()
+    {
+        if(tiny_count::m_value != tiny_count::overflowed)
+        {
+            --tiny_count::m_value;
+            return *this;
+        }
+
+        side_table& spilled = tiny_count::table();
+        tiny_count::lock(spilled);
+        entry* removed = nullptr;
+        if(--tiny_count::find(spilled, this)->value == tiny_count::overflowed - 1)
+        {
+            // Move the count back inline and remove it from the side table.
+            entry** link = &spilled.head;
+            while((*link)->key != this)
+            {
+                link = &(*link)->next;
+            }
+            removed = *link;
+            *link = removed->next;
+            tiny_count::m_value = tiny_count::overflowed - 1;
+        }
+        tiny_count::unlock(spilled);
+        delete removed;
+
+        return *this;
+    }
+
+private:
+    // TYPES
+    /// \brief An entry of the side table.
+    struct entry
+    {
+        /// \brief The tiny_count that overflowed.
+        const tiny_count* key;
+        /// \brief The value of the count.
+        size_t value;
+        /// \brief The next entry of the side table.
+        entry* next;
+    };
+
+    // VALUE
+    /// \brief The inline value that marks a count held in the side table.
+    static const uint8_t overflowed = 255;
+    /// \brief The value of the count, or overflowed if the value is held in the side table.
+    uint8_t m_value;
+
+    // SIDE TABLE
+    /// \brief The side table of overflowed counts.
+    struct side_table
+    {
+        /// \brief The first entry of the side table.
+        entry* head;
+#ifndef ARDUINO
+        /// \brief Serializes the side table across threads.
+        std::mutex mutex;
+#endif
+    };
+    /// \brief Gets the side table.
+    /// \return A reference to the side table.
+    static side_table& table()
+    {
+        static side_table spilled = {};
+        return spilled;
+    }
+    /// \brief Locks the side table. Does nothing on Arduino.
+    /// \param spilled The side table.
+    static void lock(side_table& spilled)
+    {
+#ifndef ARDUINO
+        spilled.mutex.lock();
+#else
+        (void)spilled;
+#endif
+    }
+    /// \brief Unlocks the side table. Does nothing on Arduino.
+    /// \param spilled The side table.
+    static void unlock(side_table& spilled)
+    {
+#ifndef ARDUINO
+        spilled.mutex.unlock();
+#else
+        (void)spilled;
+#endif
+    }
+    /// \brief Finds the side table entry of an overflowed count. The side table must be locked.
+    /// \param spilled The side table.
+    /// \param key The tiny_count that overflowed.
+    /// \return A pointer to the entry.
+    static entry* find(const side_table& spilled, const tiny_count* key)
+    {
+        entry* current = spilled.head;
+        while(current->key != key)
+        {
+            current = current->next;
+        }
+        return current;
+    }
+};
+
+#endif
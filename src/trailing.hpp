@@ -0,0 +1,118 @@
+/// \file trailing.hpp
+/// \brief Defines factories for objects followed by variable-length trailing data in the same allocation.
+#ifndef SMART_PTR___TRAILING_H
+#define SMART_PTR___TRAILING_H
+
+#include <shared_ptr.hpp>
+#include <shared_group.hpp>
+#include <unique_ptr.hpp>
+
+#include <new>
+#include <stdint.h>
+
+/// \brief Gets the trailing data of an object created by make_shared_trailing() or make_unique_trailing().
+/// \details The trailing data starts directly after the object and is not aligned beyond the object's alignment.
+/// \tparam object_type The type of the object.
+/// \param object A pointer to the object.
+/// \return A pointer to the first byte of the trailing data.
+template <class object_type>
+uint8_t* trailing_data(object_type* object)
+{
+    return reinterpret_cast<uint8_t*>(object + 1);
+}
+
+/// \brief Creates a shared_ptr managing a new instance of an object, followed by trailing data in one allocation.
+/// \details The counts, the object, and the trailing data share a single allocation. The trailing data is not
+/// initialized; use trailing_data() to access it. try_unwrap() refuses the object, since moving it out of the
+/// allocation would lose the trailing data.
+/// \tparam object_type The type of the object.
+/// \tparam args The variadic types of the object's constructor parameters.
+/// \param trailing_bytes The number of bytes of trailing data.
+/// \param arguments The arguments to pass to the object's constructor.
+/// \return A shared_ptr managing the new instance of the object.
+template <class object_type, class... args>
+shared_ptr<object_type> make_shared_trailing(size_t trailing_bytes, args&&... arguments)
+{
+    // Allocate a group of one object with the trailing data after it.
+    shared_group_count<object_type>* count = shared_group_count<object_type>::allocate_trailing(trailing_bytes);
+    new (count->objects()) object_type(arguments...);
+
+    shared_group<object_type> group(count);
+    return static_cast<shared_ptr<object_type>&&>(group.m_objects);
+}
+
+/// \brief The deleter of objects created by make_unique_trailing(), which also frees the trailing data.
+/// \details When instrumentation is enabled, the allocation starts with a header holding the size of the object and
+/// its trailing data, so that the instrumentation tools see the full size when the object is freed.
+/// \tparam object_type The type of the object.
+template <class object_type>
+struct trailing_delete
+{
+    /// \brief Destroys an object instance and frees its allocation.
+    /// \param object The object instance to delete.
+    void operator()(object_type* object) const
+    {
+        object->~object_type();
+        ::operator delete(trailing_delete::allocation(object));
+    }
+
+    // LAYOUT
+    /// \brief Gets the offset of the object from the start of its allocation.
+    /// \return The size of the header, rounded up to the alignment of the object, or zero without instrumentation.
+    static size_t header()
+    {
+#ifdef SMART_PTR_INSTRUMENTED
+        return (sizeof(size_t) + alignof(object_type) - 1) / alignof(object_type) * alignof(object_type);
+#else
+        return 0;
+#endif
+    }
+    /// \brief Gets the start of the allocation holding an object.
+    /// \param object The object.
+    /// \return A pointer to the start of the allocation.
+    static void* allocation(const object_type* object)
+    {
+        return const_cast<uint8_t*>(reinterpret_cast<const uint8_t*>(object)) - trailing_delete::header();
+    }
+};
+
+/// \brief Gets the size of an object created by make_unique_trailing() together with its trailing data.
+/// \tparam object_type The type of the object.
+template <class object_type>
+struct unique_ptr_size<object_type, trailing_delete<object_type>>
+{
+    /// \brief Gets the size of an object and its trailing data.
+    /// \param object The object.
+    /// \return The size in bytes, read from the allocation's header when instrumentation is enabled.
+    static size_t of(const object_type* object)
+    {
+#ifdef SMART_PTR_INSTRUMENTED
+        return *static_cast<const size_t*>(trailing_delete<object_type>::allocation(object));
+#else
+        (void)object;
+        return sizeof(object_type);
+#endif
+    }
+};
+
+/// \brief Creates a unique_ptr managing a new instance of an object, followed by trailing data in one allocation.
+/// \details The trailing data is not initialized; use trailing_data() to access it.
+/// \tparam object_type The type of the object.
+/// \tparam args The variadic types of the object's constructor parameters.
+/// \param trailing_bytes The number of bytes of trailing data.
+/// \param arguments The arguments to pass to the object's constructor.
+/// \return A unique_ptr managing the new instance of the object.
+template <class object_type, class... args>
+unique_ptr<object_type, trailing_delete<object_type>> make_unique_trailing(size_t trailing_bytes, args&&... arguments)
+{
+    // Store the size ahead of the object for the instrumentation tools.
+    uint8_t* memory = static_cast<uint8_t*>(::operator new(trailing_delete<object_type>::header() + sizeof(object_type) + trailing_bytes));
+#ifdef SMART_PTR_INSTRUMENTED
+    new (memory) size_t(sizeof(object_type) + trailing_bytes);
+#endif
+
+    object_type* object = new (memory + trailing_delete<object_type>::header()) object_type(arguments...);
+    return unique_ptr<object_type, trailing_delete<object_type>>(object);
+}
+
+#endif
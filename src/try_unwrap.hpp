@@ -0,0 +1,73 @@
+/// \file try_unwrap.hpp
+/// \brief Defines functions for taking the object out of a uniquely owned shared_ptr.
+#ifndef SMART_PTR___TRY_UNWRAP_H
+#define SMART_PTR___TRY_UNWRAP_H
+
+#include <shared_group.hpp>
+#include <shared_ptr.hpp>
+#include <unique_ptr.hpp>
+
+/// \brief Moves ownership of a shared_ptr's object into a unique_ptr if the shared_ptr is its only owner.
+/// \details Objects allocated on their own are handed over without copying or reallocating. Objects that share an
+/// allocation with their counts, such as those created by make_shared_n(), are moved into a new allocation.
+/// Objects created by make_shared_trailing() are never unwrapped, since their trailing data cannot be moved with
+/// them. Any weak_ptrs to the object expire.
+/// \tparam object_type The type of the object.
+/// \param pointer The shared_ptr to unwrap. Left empty on success, and unchanged otherwise.
+/// \param object The unique_ptr that receives ownership of the object on success.
+/// \return TRUE if the object was moved into the unique_ptr, or FALSE if other shared_ptrs reference it or it has
+/// trailing data.
+template <class object_type>
+bool try_unwrap(shared_ptr<object_type>&& pointer, unique_ptr<object_type>& object)
+{
+    // Check if the shared_ptr is the only owner of an object without trailing data.
+    if(!pointer.unique() || shared_group_count<object_type>::trailing(*pointer.m_count))
+    {
+        return false;
+    }
+
+    // Move objects that live inside the counts' allocation into their own allocation.
+    if(pointer.m_count->manages_objects())
+    {
+        object.reset(new object_type(static_cast<object_type&&>(*pointer)));
+        pointer.reset();
+        return true;
+    }
+
+    // Release the shared reference without destroying the object.
+    pointer.m_count->decrement_use_count();
+    pointer.m_count->decrement_weak_count();
+    smart_ptr_hooks::free<object_type>(pointer.m_object, sizeof(object_type));
+    object.reset(pointer.m_object);
+
+    // Clear the shared_ptr.
+    pointer.m_object = nullptr;
+    pointer.m_count = nullptr;
+
+    return true;
+}
+/// \brief Moves a shared_ptr's object into a value if the shared_ptr is its only owner.
+/// \details The object is move assigned into the value, and the moved-from object is then released. Objects created
+/// by make_shared_trailing() are never unwrapped, since their trailing data cannot be moved with them.
+/// \tparam object_type The type of the object.
+/// \param pointer The shared_ptr to unwrap. Left empty on success, and unchanged otherwise.
+/// \param object The value that receives the object on success.
+/// \return TRUE if the object was moved into the value, or FALSE if other shared_ptrs reference it or it has
+/// trailing data.
+template <class object_type>
+bool try_unwrap(shared_ptr<object_type>&& pointer, object_type& object)
+{
+    // Check if the shared_ptr is the only owner of an object without trailing data.
+    if(!pointer.unique() || !pointer || shared_group_count<object_type>::trailing(*pointer.m_count))
+    {
+        return false;
+    }
+
+    // Move the object out and release the moved-from shell.
+    object = static_cast<object_type&&>(*pointer);
+    pointer.reset();
+
+    return true;
+}
+
+#endif
@@ -3,10 +3,52 @@
 #ifndef SMART_PTR___UNIQUE_PTR_H
 #define SMART_PTR___UNIQUE_PTR_H
 
-/// \brief A smart pointer that retains unique ownership of an object through a pointer.
+#include <default_delete.hpp>
+#include <smart_ptr_check.hpp>
+#include <smart_ptr_hooks.hpp>
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// \brief Exposes the unique_ptr that links an object to its successor in a chain.
+/// \details Specialize this for node types that own their successor through a unique_ptr member, so that
+/// destroying the head of a chain releases the whole chain in a loop instead of through recursive destructors.
+/// The specialization must be declared before any unique_ptr of the node type is destroyed.
 /// \tparam object_type The type of the object.
 template <class object_type>
+struct unique_ptr_link
+{
+    /// \brief Gets the unique_ptr that owns the successor of an object.
+    /// \param object The object.
+    /// \return A pointer to the successor link, or nullptr if the object has no successor link.
+    static unique_ptr<object_type>* next(object_type& /* object */)
+    {
+        return nullptr;
+    }
+};
+
+/// \brief Gets the size of the allocation holding an object owned by a unique_ptr, as reported to the
+/// instrumentation tools.
+/// \details Specialize this for deleters that free more than the object itself.
+/// \tparam object_type The type of the object.
+/// \tparam deleter_type The type of the deleter.
+template <class object_type, class deleter_type>
+struct unique_ptr_size
+{
+    /// \brief Gets the size of an object's allocation.
+    /// \return The size of the allocation in bytes.
+    static size_t of(const object_type* /* object */)
+    {
+        return sizeof(object_type);
+    }
+};
+
+/// \brief A smart pointer that retains unique ownership of an object through a pointer.
+/// \tparam object_type The type of the object.
+/// \tparam deleter_type The type of the stateless deleter that releases the object.
+template <class object_type, class deleter_type>
 class unique_ptr
+    : private deleter_type
 {
 public:
     // CONSTRUCTORS
@@ -18,20 +60,24 @@ public:
     /// \param pointer A pointer to an object instance to manage.
     unique_ptr(object_type* pointer)
         : m_object(pointer)
-    {}
+    {
+        // Report the adopted object to the instrumentation tools.
+        unique_ptr::report_allocation();
+    }
     /// \brief Move constructs from another unique pointer instance.
     /// \param other The unique_ptr instance to move.
-    unique_ptr(unique_ptr<object_type>&& other)
+    unique_ptr(unique_ptr<object_type, deleter_type>&& other)
         : m_object(other.m_object)
     {
         // Clear other's instance.
         other.m_object = nullptr;
+        smart_ptr_hooks::move<object_type>(unique_ptr::m_object);
     }
-    unique_ptr(const unique_ptr<object_type>& other) = delete;
+    unique_ptr(const unique_ptr<object_type, deleter_type>& other) = delete;
     ~unique_ptr()
     {
         // Delete the object instance.
-        delete unique_ptr::m_object;
+        unique_ptr::destroy(unique_ptr::m_object);
     }
 
     // RESET
@@ -39,7 +85,7 @@ public:
     void reset()
     {
         // Delete and reset the object instance.
-        delete unique_ptr::m_object;
+        unique_ptr::destroy(unique_ptr::m_object);
         unique_ptr::m_object = nullptr;
     }
     /// \brief Resets the unique_ptr to a new instance.
@@ -47,28 +93,48 @@ public:
     void reset(object_type* pointer)
     {
         // Delete old instance and store new instance.
-        delete unique_ptr::m_object;
+        unique_ptr::destroy(unique_ptr::m_object);
         unique_ptr::m_object = pointer;
+
+        // Report the adopted object to the instrumentation tools.
+        unique_ptr::report_allocation();
+    }
+    /// \brief Releases ownership of the managed object instance without deleting it.
+    /// \return A pointer to the released object instance.
+    object_type* release()
+    {
+        // Report that the library no longer owns the instance.
+        object_type* object = unique_ptr::m_object;
+        if(object)
+        {
+            smart_ptr_hooks::free<object_type>(object, unique_ptr_size<object_type, deleter_type>::of(object));
+        }
+
+        // Clear the instance and hand it to the caller.
+        unique_ptr::m_object = nullptr;
+        return object;
     }
     
     // ASSIGNMENT
     /// \brief Move assigns this unique_ptr from another unique_ptr.
     /// \param other The unique_ptr instance to move.
     /// \return A reference to this unique_ptr.
-    unique_ptr<object_type>& operator=(unique_ptr<object_type>&& other)
+    unique_ptr<object_type, deleter_type>& operator=(unique_ptr<object_type, deleter_type>&& other)
     {
+        // Take other's instance first, since deleting the old instance may destroy other.
+        object_type* object = other.m_object;
+        other.m_object = nullptr;
+
         // Delete old instance.
-        delete unique_ptr::m_object;
+        unique_ptr::destroy(unique_ptr::m_object);
 
         // Store new instance.
-        unique_ptr::m_object = other.m_object;
-
-        // Remove instance from other object.
-        other.m_object = nullptr;
+        unique_ptr::m_object = object;
+        smart_ptr_hooks::move<object_type>(unique_ptr::m_object);
         
         return *this;
     }
-    unique_ptr<object_type>& operator=(const unique_ptr<object_type>& other) = delete;
+    unique_ptr<object_type, deleter_type>& operator=(const unique_ptr<object_type, deleter_type>& other) = delete;
 
     // ACCESS
     /// \brief Gets the pointer to the managed object instance.
@@ -81,12 +147,14 @@ public:
     /// \return A pointer to the object instance.
     object_type* operator->() const
     {
+        SMART_PTR_CHECK(unique_ptr::m_object);
         return unique_ptr::m_object;
     }
     /// \brief Dereferences the pointer to the managed object instance.
     /// \return A reference to the object instance.
     object_type& operator*() const
     {
+        SMART_PTR_CHECK(unique_ptr::m_object);
         return *unique_ptr::m_object;
     }
     /// \brief Checks if this unique_ptr references an object instance.
@@ -100,8 +168,366 @@ private:
     // OBJECT
     /// \brief A pointer to the unique object instance.
     object_type* m_object;
+
+    // DESTRUCTION
+    /// \brief Deletes an object instance along with the chain of successors it uniquely owns.
+    /// \details Successors are detached before their predecessor is deleted, so the stack depth stays constant.
+    /// \param object The object instance to delete.
+    void destroy(object_type* object)
+    {
+        // Check if there is an object instance.
+        if(!object)
+        {
+            return;
+        }
+
+        // Delete the object with this unique_ptr's deleter.
+        object_type* next = unique_ptr::detach_successor(*object);
+        smart_ptr_hooks::free<object_type>(object, unique_ptr_size<object_type, deleter_type>::of(object));
+        deleter_type::operator()(object);
+
+        // Successors are owned through unique_ptr<object_type> links, so they use the default deleter.
+        // Their frees were already reported when they were released from their links.
+        while(next)
+        {
+            object = next;
+            next = unique_ptr::detach_successor(*object);
+            default_delete<object_type>()(object);
+        }
+    }
+    /// \brief Reports a newly adopted object to the instrumentation tools.
+    void report_allocation()
+    {
+        if(unique_ptr::m_object)
+        {
+            smart_ptr_hooks::allocate<object_type>(unique_ptr::m_object, unique_ptr_size<object_type, deleter_type>::of(unique_ptr::m_object));
+        }
+    }
+    /// \brief Detaches the successor of an object so that deleting the object does not recurse into it.
+    /// \param object The object.
+    /// \return A pointer to the detached successor, or nullptr if the object has no successor.
+    static object_type* detach_successor(object_type& object)
+    {
+        unique_ptr<object_type>* link = unique_ptr_link<object_type>::next(object);
+        return link ? link->release() : nullptr;
+    }
 };
 
+/// \brief A smart pointer that retains unique ownership of an array of objects through a pointer.
+/// \tparam object_type The type of the array's elements.
+/// \tparam deleter_type The type of the stateless deleter that releases the array.
+template <class object_type, class deleter_type>
+class unique_ptr<object_type[], deleter_type>
+    : private deleter_type
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Creates a new, empty unique_ptr instance.
+    unique_ptr()
+        : m_objects(nullptr)
+    {
+        unique_ptr::set_size(0);
+    }
+    /// \brief Creates a new unique_ptr instance.
+    /// \details The size of the array is unknown, so it is not reported to the instrumentation tools.
+    /// \param pointer A pointer to an array of object instances to manage.
+    unique_ptr(object_type* pointer)
+        : m_objects(pointer)
+    {
+        unique_ptr::set_size(0);
+    }
+    /// \brief Creates a new unique_ptr instance managing an array of known size.
+    /// \param pointer A pointer to an array of object instances to manage.
+    /// \param size The number of elements in the array, reported to the instrumentation tools.
+    unique_ptr(object_type* pointer, size_t size)
+        : m_objects(pointer)
+    {
+        unique_ptr::set_size(size);
+
+        // Report the adopted array to the instrumentation tools.
+        unique_ptr::report_allocation();
+    }
+    /// \brief Move constructs from another unique pointer instance.
+    /// \param other The unique_ptr instance to move.
+    unique_ptr(unique_ptr<object_type[], deleter_type>&& other)
+        : m_objects(other.m_objects)
+    {
+        unique_ptr::set_size(other.size());
+
+        // Clear other's array.
+        other.m_objects = nullptr;
+        other.set_size(0);
+    }
+    unique_ptr(const unique_ptr<object_type[], deleter_type>& other) = delete;
+    ~unique_ptr()
+    {
+        // Delete the array.
+        unique_ptr::destroy(unique_ptr::m_objects);
+    }
+
+    // RESET
+    /// \brief Resets the unique_ptr to nullptr.
+    void reset()
+    {
+        // Delete and reset the array.
+        unique_ptr::destroy(unique_ptr::m_objects);
+        unique_ptr::m_objects = nullptr;
+        unique_ptr::set_size(0);
+    }
+    /// \brief Resets the unique_ptr to a new array.
+    /// \param pointer The pointer to the new array to manage.
+    void reset(object_type* pointer)
+    {
+        // Delete old array and store new array, whose size is unknown.
+        unique_ptr::destroy(unique_ptr::m_objects);
+        unique_ptr::m_objects = pointer;
+        unique_ptr::set_size(0);
+    }
+    /// \brief Releases ownership of the managed array without deleting it.
+    /// \return A pointer to the released array.
+    object_type* release()
+    {
+        // Report that the library no longer owns the array.
+        object_type* objects = unique_ptr::m_objects;
+        unique_ptr::report_free();
+
+        // Clear the array and hand it to the caller.
+        unique_ptr::m_objects = nullptr;
+        unique_ptr::set_size(0);
+        return objects;
+    }
+
+    // ASSIGNMENT
+    /// \brief Move assigns this unique_ptr from another unique_ptr.
+    /// \param other The unique_ptr instance to move.
+    /// \return A reference to this unique_ptr.
+    unique_ptr<object_type[], deleter_type>& operator=(unique_ptr<object_type[], deleter_type>&& other)
+    {
+        // Delete old array.
+        unique_ptr::destroy(unique_ptr::m_objects);
+
+        // Store new array.
+        unique_ptr::m_objects = other.m_objects;
+        unique_ptr::set_size(other.size());
+
+        // Remove array from other object.
+        other.m_objects = nullptr;
+        other.set_size(0);
+
+        return *this;
+    }
+    unique_ptr<object_type[], deleter_type>& operator=(const unique_ptr<object_type[], deleter_type>& other) = delete;
+
+    // ACCESS
+    /// \brief Gets the pointer to the first element of the managed array.
+    /// \return A pointer to the first element.
+    object_type* get() const
+    {
+        return unique_ptr::m_objects;
+    }
+    /// \brief Gets an element of the managed array by index.
+    /// \param index The index of the element.
+    /// \return A reference to the element.
+    object_type& operator[](size_t index) const
+    {
+        SMART_PTR_CHECK(unique_ptr::m_objects);
+        return unique_ptr::m_objects[index];
+    }
+    /// \brief Checks if this unique_ptr references an array.
+    /// \return TRUE if this unique_ptr references an array, false if it is nullptr.
+    operator bool() const
+    {
+        return unique_ptr::m_objects != nullptr;
+    }
+
+private:
+    // OBJECTS
+    /// \brief A pointer to the first element of the unique array.
+    object_type* m_objects;
+#ifdef SMART_PTR_INSTRUMENTED
+    /// \brief The number of elements in the array, or zero if unknown.
+    size_t m_size;
+#endif
+
+    // DESTRUCTION
+    /// \brief Deletes an array with this unique_ptr's deleter.
+    /// \param objects The array to delete.
+    void destroy(object_type* objects)
+    {
+        if(objects)
+        {
+            unique_ptr::report_free();
+            deleter_type::operator()(objects);
+        }
+    }
+
+    // INSTRUMENTATION
+    /// \brief Gets the number of elements in the array, which is only tracked while instrumentation is enabled.
+    /// \return The number of elements, or zero if unknown.
+    size_t size() const
+    {
+#ifdef SMART_PTR_INSTRUMENTED
+        return unique_ptr::m_size;
+#else
+        return 0;
+#endif
+    }
+    /// \brief Stores the number of elements in the array while instrumentation is enabled.
+    /// \param size The number of elements, or zero if unknown.
+    void set_size(size_t size)
+    {
+#ifdef SMART_PTR_INSTRUMENTED
+        unique_ptr::m_size = size;
+#else
+        (void)size;
+#endif
+    }
+    /// \brief Reports a newly adopted array of known size to the instrumentation tools.
+    void report_allocation()
+    {
+        if(unique_ptr::m_objects && unique_ptr::size())
+        {
+            smart_ptr_hooks::allocate<object_type>(unique_ptr::m_objects, unique_ptr::size() * sizeof(object_type));
+        }
+    }
+    /// \brief Reports that the array of known size is no longer owned to the instrumentation tools.
+    void report_free()
+    {
+        if(unique_ptr::m_objects && unique_ptr::size())
+        {
+            smart_ptr_hooks::free<object_type>(unique_ptr::m_objects, unique_ptr::size() * sizeof(object_type));
+        }
+    }
+};
+
+/// \brief Selects between the factory overloads for single objects and for arrays of unknown bound.
+/// \tparam object_type The type passed to the factory.
+template <class object_type>
+struct unique_ptr_factory
+{
+    /// \brief The unique_ptr returned by the single object factories.
+    typedef unique_ptr<object_type> single_type;
+};
+/// \brief Selects between the factory overloads for single objects and for arrays of unknown bound.
+/// \tparam object_type The type of the array's elements.
+template <class object_type>
+struct unique_ptr_factory<object_type[]>
+{
+    /// \brief The type of the array's elements.
+    typedef object_type element_type;
+    /// \brief The unique_ptr returned by the array factories.
+    typedef unique_ptr<object_type[]> array_type;
+};
+
+// COMPARISON
+/// \brief Checks if two unique_ptrs point to the same object.
+/// \tparam object_type The type of the object.
+/// \tparam deleter_type The type of the deleter.
+/// \param a The first unique_ptr.
+/// \param b The second unique_ptr.
+/// \return TRUE if both point to the same object or are both empty, otherwise FALSE.
+template <class object_type, class deleter_type>
+bool operator==(const unique_ptr<object_type, deleter_type>& a, const unique_ptr<object_type, deleter_type>& b)
+{
+    return a.get() == b.get();
+}
+/// \brief Checks if two unique_ptrs point to different objects.
+/// \tparam object_type The type of the object.
+/// \tparam deleter_type The type of the deleter.
+/// \param a The first unique_ptr.
+/// \param b The second unique_ptr.
+/// \return TRUE if they point to different objects, otherwise FALSE.
+template <class object_type, class deleter_type>
+bool operator!=(const unique_ptr<object_type, deleter_type>& a, const unique_ptr<object_type, deleter_type>& b)
+{
+    return a.get() != b.get();
+}
+/// \brief Orders two unique_ptrs by the address of their objects.
+/// \details Addresses are compared as integers, so the order is total even across separate allocations.
+/// \tparam object_type The type of the object.
+/// \tparam deleter_type The type of the deleter.
+/// \param a The first unique_ptr.
+/// \param b The second unique_ptr.
+/// \return TRUE if a's object is ordered before b's, otherwise FALSE.
+template <class object_type, class deleter_type>
+bool operator<(const unique_ptr<object_type, deleter_type>& a, const unique_ptr<object_type, deleter_type>& b)
+{
+    return reinterpret_cast<uintptr_t>(a.get()) < reinterpret_cast<uintptr_t>(b.get());
+}
+/// \brief Orders two unique_ptrs by the address of their objects.
+/// \tparam object_type The type of the object.
+/// \tparam deleter_type The type of the deleter.
+/// \param a The first unique_ptr.
+/// \param b The second unique_ptr.
+/// \return TRUE if a's object is ordered after b's, otherwise FALSE.
+template <class object_type, class deleter_type>
+bool operator>(const unique_ptr<object_type, deleter_type>& a, const unique_ptr<object_type, deleter_type>& b)
+{
+    return b < a;
+}
+/// \brief Orders two unique_ptrs by the address of their objects.
+/// \tparam object_type The type of the object.
+/// \tparam deleter_type The type of the deleter.
+/// \param a The first unique_ptr.
+/// \param b The second unique_ptr.
+/// \return TRUE if a's object is not ordered after b's, otherwise FALSE.
+template <class object_type, class deleter_type>
+bool operator<=(const unique_ptr<object_type, deleter_type>& a, const unique_ptr<object_type, deleter_type>& b)
+{
+    return !(b < a);
+}
+/// \brief Orders two unique_ptrs by the address of their objects.
+/// \tparam object_type The type of the object.
+/// \tparam deleter_type The type of the deleter.
+/// \param a The first unique_ptr.
+/// \param b The second unique_ptr.
+/// \return TRUE if a's object is not ordered before b's, otherwise FALSE.
+template <class object_type, class deleter_type>
+bool operator>=(const unique_ptr<object_type, deleter_type>& a, const unique_ptr<object_type, deleter_type>& b)
+{
+    return !(a < b);
+}
+/// \brief Checks if a unique_ptr is empty.
+/// \tparam object_type The type of the object.
+/// \tparam deleter_type The type of the deleter.
+/// \param pointer The unique_ptr.
+/// \return TRUE if the unique_ptr is empty, otherwise FALSE.
+template <class object_type, class deleter_type>
+bool operator==(const unique_ptr<object_type, deleter_type>& pointer, decltype(nullptr))
+{
+    return !pointer;
+}
+/// \brief Checks if a unique_ptr is empty.
+/// \tparam object_type The type of the object.
+/// \tparam deleter_type The type of the deleter.
+/// \param pointer The unique_ptr.
+/// \return TRUE if the unique_ptr is empty, otherwise FALSE.
+template <class object_type, class deleter_type>
+bool operator==(decltype(nullptr), const unique_ptr<object_type, deleter_type>& pointer)
+{
+    return !pointer;
+}
+/// \brief Checks if a unique_ptr is not empty.
+/// \tparam object_type The type of the object.
+/// \tparam deleter_type The type of the deleter.
+/// \param pointer The unique_ptr.
+/// \return TRUE if the unique_ptr points to an object, otherwise FALSE.
+template <class object_type, class deleter_type>
+bool operator!=(const unique_ptr<object_type, deleter_type>& pointer, decltype(nullptr))
+{
+    return static_cast<bool>(pointer);
+}
+/// \brief Checks if a unique_ptr is not empty.
+/// \tparam object_type The type of the object.
+/// \tparam deleter_type The type of the deleter.
+/// \param pointer The unique_ptr.
+/// \return TRUE if the unique_ptr points to an object, otherwise FALSE.
+template <class object_type, class deleter_type>
+bool operator!=(decltype(nullptr), const unique_ptr<object_type, deleter_type>& pointer)
+{
+    return static_cast<bool>(pointer);
+}
+
 // UTILITIES
 /// \brief Creates a unique_ptr managing a new instance of an object.
 /// \tparam object_type The type of the object.
@@ -109,9 +535,38 @@ private:
 /// \param arguments The arguments to pass to the object's constructor.
 /// \return A unique_ptr managing a new instance of the object.
 template <class object_type, class... args>
-unique_ptr<object_type> make_unique(args&&... arguments)
+typename unique_ptr_factory<object_type>::single_type make_unique(args&&... arguments)
 {
     return unique_ptr<object_type>(new object_type(arguments...));
 }
+/// \brief Creates a unique_ptr managing a new array of value-initialized objects.
+/// \tparam array_type The type of the array, as element_type[].
+/// \param size The number of elements in the array.
+/// \return A unique_ptr managing the new array.
+template <class array_type>
+typename unique_ptr_factory<array_type>::array_type make_unique(size_t size)
+{
+    return unique_ptr<array_type>(new typename unique_ptr_factory<array_type>::element_type[size](), size);
+}
+/// \brief Creates a unique_ptr managing a new, default-initialized instance of an object.
+/// \details Unlike make_unique(), members without a default member initializer are left uninitialized, which
+/// avoids writing every byte of a buffer that is about to be overwritten.
+/// \tparam object_type The type of the object.
+/// \return A unique_ptr managing a new instance of the object.
+template <class object_type>
+typename unique_ptr_factory<object_type>::single_type make_unique_for_overwrite()
+{
+    return unique_ptr<object_type>(new object_type);
+}
+/// \brief Creates a unique_ptr managing a new array of default-initialized objects.
+/// \details Elements of trivial types are left uninitialized.
+/// \tparam array_type The type of the array, as element_type[].
+/// \param size The number of elements in the array.
+/// \return A unique_ptr managing the new array.
+template <class array_type>
+typename unique_ptr_factory<array_type>::array_type make_unique_for_overwrite(size_t size)
+{
+    return unique_ptr<array_type>(new typename unique_ptr_factory<array_type>::element_type[size], size);
+}
 
 #endif
\ No newline at end of file
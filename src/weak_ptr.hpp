@@ -0,0 +1,192 @@
+/// \file weak_ptr.hpp
+/// \brief Defines the weak_ptr class.
+#ifndef SMART_PTR___WEAK_PTR_H
+#define SMART_PTR___WEAK_PTR_H
+
+#include <shared_ptr.hpp>
+
+/// \brief A smart pointer that references an object owned by shared_ptrs without keeping it alive.
+/// \tparam object_type The type of the object.
+template <class object_type>
+class weak_ptr
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Creates a new, empty weak_ptr instance.
+    weak_ptr()
+        : m_object(nullptr),
+          m_count(nullptr)
+    {}
+    /// \brief Creates a new weak_ptr instance referencing the object of a shared_ptr.
+    /// \param pointer The shared_ptr managing the object.
+    weak_ptr(const shared_ptr<object_type>& pointer)
+        : m_object(pointer.m_object),
+          m_count(pointer.m_count)
+    {
+        // Increment weak count.
+        weak_ptr::increment_weak_count();
+    }
+    /// \brief Copy constructs from another weak pointer instance.
+    /// \param other The weak_ptr instance to copy.
+    weak_ptr(const weak_ptr<object_type>& other)
+        : m_object(other.m_object),
+          m_count(other.m_count)
+    {
+        // Increment weak count.
+        weak_ptr::increment_weak_count();
+    }
+    /// \brief Move constructs from another weak pointer instance.
+    /// \param other The weak_ptr instance to move.
+    weak_ptr(weak_ptr<object_type>&& other)
+        : m_object(other.m_object),
+          m_count(other.m_count)
+    {
+        // Clear other's instance/count.
+        // NOTE: weak count remains the same due to move.
+        other.m_object = nullptr;
+        other.m_count = nullptr;
+    }
+    ~weak_ptr()
+    {
+        // Decrement weak count.
+        weak_ptr::decrement_weak_count();
+    }
+
+    // RESET
+    /// \brief Resets the weak_ptr to nullptr.
+    void reset()
+    {
+        // Decrement weak count.
+        weak_ptr::decrement_weak_count();
+
+        // Reset object and count.
+        weak_ptr::m_object = nullptr;
+        weak_ptr::m_count = nullptr;
+    }
+
+    // ASSIGNMENT
+    /// \brief Copy assigns this weak_ptr from another weak_ptr.
+    /// \param other The weak_ptr instance to copy.
+    /// \return A reference to this weak_ptr.
+    weak_ptr<object_type>& operator=(const weak_ptr<object_type>& other)
+    {
+        // Increment new weak count first, in case both reference the same counts.
+        if(other.m_count)
+        {
+            other.m_count->increment_weak_count();
+        }
+        weak_ptr::decrement_weak_count();
+
+        // Copy object and count.
+        weak_ptr::m_object = other.m_object;
+        weak_ptr::m_count = other.m_count;
+
+        return *this;
+    }
+    /// \brief Move assigns this weak_ptr from another weak_ptr.
+    /// \param other The weak_ptr instance to move.
+    /// \return A reference to this weak_ptr.
+    weak_ptr<object_type>& operator=(weak_ptr<object_type>&& other)
+    {
+        // Decrement current weak count.
+        weak_ptr::decrement_weak_count();
+
+        // Copy object and count.
+        weak_ptr::m_object = other.m_object;
+        weak_ptr::m_count = other.m_count;
+
+        // Clear object and count on other instance.
+        other.m_object = nullptr;
+        other.m_count = nullptr;
+
+        return *this;
+    }
+    /// \brief Assigns this weak_ptr to reference the object of a shared_ptr.
+    /// \param pointer The shared_ptr managing the object.
+    /// \return A reference to this weak_ptr.
+    weak_ptr<object_type>& operator=(const shared_ptr<object_type>& pointer)
+    {
+        return *this = weak_ptr<object_type>(pointer);
+    }
+
+    // ACCESS
+    /// \brief Creates a shared_ptr to the referenced object, if it still exists.
+    /// \return A shared_ptr managing the object, or an empty shared_ptr if the object has been destroyed.
+    shared_ptr<object_type> lock() const
+    {
+        // Check if the object still exists.
+        if(weak_ptr::m_count && weak_ptr::m_count->lock())
+        {
+            return shared_ptr<object_type>(weak_ptr::m_object, weak_ptr::m_count);
+        }
+        else
+        {
+            return shared_ptr<object_type>();
+        }
+    }
+    /// \brief Indicates if the referenced object has been destroyed.
+    /// \return TRUE if the object no longer exists or this weak_ptr is empty, otherwise FALSE.
+    bool expired() const
+    {
+        return weak_ptr::use_count() == 0;
+    }
+    /// \brief Gets the number of shared_ptrs referencing the object.
+    /// \return The number of shared references.
+    size_t use_count() const
+    {
+        // Check if count exists.
+        if(weak_ptr::m_count)
+        {
+            return weak_ptr::m_count->use_count();
+        }
+        else
+        {
+            return 0;
+        }
+    }
+
+    // OWNERSHIP
+    /// \brief Orders this weak_ptr against another by the counts they share, which stay valid after the object expires.
+    /// \param other The other weak_ptr.
+    /// \return TRUE if this weak_ptr's counts are ordered before the other's, otherwise FALSE.
+    bool owner_before(const weak_ptr<object_type>& other) const
+    {
+        return reinterpret_cast<uintptr_t>(weak_ptr::m_count) < reinterpret_cast<uintptr_t>(other.m_count);
+    }
+    /// \brief Orders this weak_ptr against a shared_ptr by the counts they share.
+    /// \param other The shared_ptr.
+    /// \return TRUE if this weak_ptr's counts are ordered before the shared_ptr's, otherwise FALSE.
+    bool owner_before(const shared_ptr<object_type>& other) const
+    {
+        return reinterpret_cast<uintptr_t>(weak_ptr::m_count) < reinterpret_cast<uintptr_t>(other.m_count);
+    }
+
+private:
+    // OBJECT
+    /// \brief A pointer to the referenced object instance.
+    object_type* m_object;
+    /// \brief A pointer to the shared reference counts of the object instance.
+    shared_count* m_count;
+
+    // WEAK COUNT
+    /// \brief Decrements the weak count of the object.
+    void decrement_weak_count()
+    {
+        if(weak_ptr::m_count)
+        {
+            weak_ptr::m_count->decrement_weak_count();
+        }
+    }
+    /// \brief Increments the weak count of the object.
+    void increment_weak_count()
+    {
+        if(weak_ptr::m_count)
+        {
+            weak_ptr::m_count->increment_weak_count();
+        }
+    }
+
+    friend class shared_ptr<object_type>;
+};
+
+#endif